@@ -0,0 +1,71 @@
+/* 
+ * File:   AllocationCounter.cpp
+ * Author: merbar
+ * 
+ * Created on August 16, 2017, 9:55 PM
+ */
+
+#include "AllocationCounter.h"
+
+#ifdef PTG_COUNT_ALLOCATIONS
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<uint64_t> allocations(0);
+
+static void *counted_malloc(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size) {
+  void *p = counted_malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size) {
+  void *p = counted_malloc(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(std::size_t size, std::nothrow_t const &) noexcept {
+  return counted_malloc(size);
+}
+
+void *operator new[](std::size_t size, std::nothrow_t const &) noexcept {
+  return counted_malloc(size);
+}
+
+void operator delete(void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+  std::free(p);
+}
+
+uint64_t heap_allocation_count() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+uint64_t heap_allocation_count() {
+  return 0;
+}
+
+#endif
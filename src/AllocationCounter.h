@@ -0,0 +1,17 @@
+/* 
+ * File:   AllocationCounter.h
+ * Author: merbar
+ *
+ * Created on August 16, 2017, 9:55 PM
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// Number of global operator new calls so far, from any thread.
+// Only counted when built with PTG_COUNT_ALLOCATIONS, which replaces the global operator new/delete. Always 0 otherwise.
+uint64_t heap_allocation_count();
+
+#endif /* ALLOCATIONCOUNTER_H */
@@ -0,0 +1,75 @@
+/*
+ * File:   Arena.cpp
+ * Author: merbar
+ *
+ * Created on August 16, 2017, 8:40 PM
+ */
+
+#include "Arena.h"
+#include <cassert>
+#include <new>
+
+// heap blocks are aligned for any fundamental type, which is all the planner allocates
+static const size_t max_alignment = alignof(max_align_t);
+
+Arena::Arena(size_t capacity) {
+  _buffer = capacity ? static_cast<char*>(::operator new(capacity)) : nullptr;
+  _capacity = capacity;
+  _used = 0;
+  _overflow = nullptr;
+  _overflow_bytes = 0;
+}
+
+Arena::~Arena() {
+  reset();
+  ::operator delete(_buffer);
+}
+
+void *Arena::allocate(size_t bytes, size_t alignment) {
+  // the buffer and the overflow blocks can't be aligned any further
+  assert((alignment <= max_alignment) && ((alignment & (alignment - 1)) == 0));
+  size_t offset = (_used + alignment - 1) & ~(alignment - 1);
+  if (offset + bytes <= _capacity) {
+    _used = offset + bytes;
+    return _buffer + offset;
+  }
+  // header padded so the block itself stays aligned
+  size_t header = (sizeof(Overflow) + max_alignment - 1) & ~(max_alignment - 1);
+  char *block = static_cast<char*>(::operator new(header + bytes));
+  Overflow *overflow = reinterpret_cast<Overflow*>(block);
+  overflow->next = _overflow;
+  _overflow = overflow;
+  _overflow_bytes += bytes + alignment;
+  return block + header;
+}
+
+bool Arena::reset() {
+  while (_overflow) {
+    Overflow *next = _overflow->next;
+    ::operator delete(_overflow);
+    _overflow = next;
+  }
+  bool grow = (_overflow_bytes > 0);
+  if (grow) {
+    size_t capacity = 2 * (_used + _overflow_bytes);
+    ::operator delete(_buffer);
+    _buffer = static_cast<char*>(::operator new(capacity));
+    _capacity = capacity;
+  }
+  _used = 0;
+  _overflow_bytes = 0;
+  return grow;
+}
+
+bool Arena::reserve(size_t bytes) {
+  if (_capacity >= bytes)
+    return false;
+  ::operator delete(_buffer);
+  _buffer = static_cast<char*>(::operator new(bytes));
+  _capacity = bytes;
+  return true;
+}
+
+size_t Arena::capacity() const {
+  return _capacity;
+}
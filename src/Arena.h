@@ -0,0 +1,87 @@
+/*
+ * File:   Arena.h
+ * Author: merbar
+ *
+ * Created on August 16, 2017, 8:40 PM
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+// Monotonic buffer for memory that only lives for one planning cycle.
+// Allocating bumps an offset, deallocating does nothing and reset() releases everything at once.
+// A cycle that needs more than the buffer holds gets the rest from the heap. The next reset()
+// then grows the buffer to that cycle's high-water mark, so steady-state cycles never touch the heap.
+class Arena {
+public:
+    Arena(size_t capacity = 0);
+    virtual ~Arena();
+
+    // alignment is a power of two up to alignof(max_align_t)
+    void *allocate(size_t bytes, size_t alignment);
+    // everything allocated since the last reset must be dead by now. Returns whether the buffer had to grow.
+    bool reset();
+    // makes sure the buffer holds at least bytes. Only right after reset(). Returns whether it had to grow.
+    bool reserve(size_t bytes);
+    size_t capacity() const;
+
+private:
+    Arena(Arena const &);
+    Arena &operator=(Arena const &);
+
+    // heap blocks of the current cycle that didn't fit, chained through their first bytes
+    struct Overflow {
+        Overflow *next;
+    };
+
+    char *_buffer;
+    size_t _capacity;
+    size_t _used;
+    Overflow *_overflow;
+    size_t _overflow_bytes;
+};
+
+// STL allocator on an Arena, for containers that don't outlive the cycle
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena &arena) : _arena(&arena) {}
+    template <class U>
+    ArenaAllocator(ArenaAllocator<U> const &other) : _arena(other.arena()) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) {
+    }
+
+    Arena *arena() const {
+        return _arena;
+    }
+
+private:
+    Arena *_arena;
+};
+
+template <class T, class U>
+bool operator==(ArenaAllocator<T> const &a, ArenaAllocator<U> const &b) {
+    return a.arena() == b.arena();
+}
+
+template <class T, class U>
+bool operator!=(ArenaAllocator<T> const &a, ArenaAllocator<U> const &b) {
+    return a.arena() != b.arena();
+}
+
+template <class T>
+using ArenaVector = vector<T, ArenaAllocator<T>>;
+
+#endif /* ARENA_H */
@@ -0,0 +1,162 @@
+/*
+ * File:   CostPolicy.h
+ * Author: merbar
+ *
+ * Created on August 12, 2017, 4:25 PM
+ */
+
+#ifndef COSTPOLICY_H
+#define COSTPOLICY_H
+
+#include <array>
+#include <ratio>
+#include "Instrumentation.h"
+
+// Composes a trajectory cost from a list of cost terms at compile time.
+// A term is a type with
+//   static char const *name();
+//   template <class Context> static double evaluate(Context const &context);
+// CostPolicy takes the weights as std::ratio, RuntimeCostPolicy keeps them in an
+// array so they can be tuned without a rebuild. Both evaluate all terms in list
+// order without any lookups.
+
+// a cost term with its weight fixed at compile time
+template <class Term, class Weight>
+struct WeightedTerm {
+    static constexpr double weight() {
+        return double(Weight::num) / double(Weight::den);
+    }
+
+    static char const *name() {
+        return Term::name();
+    }
+
+    template <class Context>
+    static double evaluate(Context const &context) {
+        return Term::evaluate(context) * weight();
+    }
+};
+
+namespace cost_policy_detail {
+
+template <int I, class Term, class Context>
+double evaluate_term(Context const &context) {
+#ifdef PTG_INSTRUMENTATION
+    uint64_t start = PTG_TICKS();
+    double value = Term::evaluate(context);
+    PTG_ADD_COST_TERM(I, PTG_TICKS() - start);
+    return value;
+#else
+    return Term::evaluate(context);
+#endif
+}
+
+// sums left to right, as a hand written a + b + c + ... would
+template <int I, class... Terms>
+struct Sum;
+
+template <int I>
+struct Sum<I> {
+    template <class Context>
+    static double weighted(Context const &, double *, double sum) {
+        return sum;
+    }
+
+    template <class Context>
+    static double runtime(Context const &, double const *, double *, double sum) {
+        return sum;
+    }
+};
+
+template <int I, class Term, class... Rest>
+struct Sum<I, Term, Rest...> {
+    template <class Context>
+    static double weighted(Context const &context, double *terms, double sum) {
+        terms[I] = evaluate_term<I, Term>(context);
+        return Sum<I + 1, Rest...>::weighted(context, terms, sum + terms[I]);
+    }
+
+    template <class Context>
+    static double runtime(Context const &context, double const *weights, double *terms, double sum) {
+        terms[I] = evaluate_term<I, Term>(context) * weights[I];
+        return Sum<I + 1, Rest...>::runtime(context, weights, terms, sum + terms[I]);
+    }
+};
+
+template <class... Terms>
+char const *term_name(int i) {
+    static char const *const names[] = {Terms::name()...};
+    return names[i];
+}
+
+} // namespace cost_policy_detail
+
+// Terms are WeightedTerm<Term, std::ratio<...>>
+template <class... Terms>
+class CostPolicy {
+public:
+    static constexpr int size = sizeof...(Terms);
+    static_assert(size <= MAX_COST_TERMS, "instrumentation has room for MAX_COST_TERMS terms");
+    typedef std::array<double, size> TermValues;
+
+    static char const *name(int i) {
+        return cost_policy_detail::term_name<Terms...>(i);
+    }
+
+    double weight(int i) const {
+        static constexpr double weights[] = {Terms::weight()...};
+        return weights[i];
+    }
+
+    // fills in the weighted value of every term and returns their sum
+    template <class Context>
+    double evaluate(Context const &context, TermValues &terms) const {
+        return cost_policy_detail::Sum<0, Terms...>::weighted(context, terms.data(), 0.0);
+    }
+};
+
+// Terms are plain terms, weighted by set_weight()
+template <class... Terms>
+class RuntimeCostPolicy {
+public:
+    static constexpr int size = sizeof...(Terms);
+    static_assert(size <= MAX_COST_TERMS, "instrumentation has room for MAX_COST_TERMS terms");
+    typedef std::array<double, size> TermValues;
+
+    RuntimeCostPolicy() {
+        _weights.fill(1.0);
+    }
+
+    template <class... Weights>
+    RuntimeCostPolicy(Weights... weights) : _weights{{double(weights)...}} {
+        static_assert(sizeof...(Weights) == size, "one weight per cost term");
+    }
+
+    static char const *name(int i) {
+        return cost_policy_detail::term_name<Terms...>(i);
+    }
+
+    double weight(int i) const {
+        return _weights[i];
+    }
+
+    void set_weight(int i, double weight) {
+        _weights[i] = weight;
+    }
+
+    template <class Context>
+    double evaluate(Context const &context, TermValues &terms) const {
+        return cost_policy_detail::Sum<0, Terms...>::runtime(context, _weights.data(), terms.data(), 0.0);
+    }
+
+private:
+    std::array<double, size> _weights;
+};
+
+template <class... Terms>
+constexpr int CostPolicy<Terms...>::size;
+
+template <class... Terms>
+constexpr int RuntimeCostPolicy<Terms...>::size;
+
+#endif /* COSTPOLICY_H */
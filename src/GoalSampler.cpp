@@ -0,0 +1,89 @@
+/* 
+ * File:   GoalSampler.cpp
+ * Author: merbar
+ * 
+ * Created on August 12, 2017, 3:20 PM
+ */
+
+#include "GoalSampler.h"
+#include <math.h>
+
+GoalSampler::GoalSampler(unsigned int seed) : _normal(0.0, 1.0) {
+  _mode = SAMPLE_HALTON;
+  this->seed(seed);
+}
+
+GoalSampler::~GoalSampler() {
+}
+
+void GoalSampler::seed(unsigned int seed) {
+  _rand_generator.seed(seed);
+  _normal.reset();
+  _halton_index = 1;
+  // Cranley-Patterson rotation: one random shift of the whole point set per seed
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  _halton_shift[0] = uniform(_rand_generator);
+  _halton_shift[1] = uniform(_rand_generator);
+}
+
+void GoalSampler::set_mode(SamplingMode mode) {
+  _mode = mode;
+}
+
+SamplingMode GoalSampler::get_mode() const {
+  return _mode;
+}
+
+void GoalSampler::normal_pair(double std_dev, double &x, double &y) {
+  if (_mode == SAMPLE_RANDOM) {
+    x = std_dev * _normal(_rand_generator);
+    y = std_dev * _normal(_rand_generator);
+    return;
+  }
+  double u_x = fmod(radical_inverse(_halton_index, 2) + _halton_shift[0], 1.0);
+  double u_y = fmod(radical_inverse(_halton_index, 3) + _halton_shift[1], 1.0);
+  _halton_index++;
+  x = std_dev * inverse_normal_cdf(u_x);
+  y = std_dev * inverse_normal_cdf(u_y);
+}
+
+// i-th element of the van der Corput sequence in the given base
+double GoalSampler::radical_inverse(unsigned int i, unsigned int base) {
+  double result = 0.0;
+  double digit_value = 1.0 / base;
+  while (i > 0) {
+    result += (i % base) * digit_value;
+    i /= base;
+    digit_value /= base;
+  }
+  return result;
+}
+
+// Acklam's rational approximation, relative error below 1.2e-9
+double GoalSampler::inverse_normal_cdf(double p) {
+  const double a[6] = {-3.969683028665376e+01,  2.209460984245205e+02, -2.759285104469687e+02,
+                        1.383577518672690e+02, -3.066479806614716e+01,  2.506628277459239e+00};
+  const double b[5] = {-5.447609879822406e+01,  1.615858368580409e+02, -1.556989798598866e+02,
+                        6.680131188771972e+01, -1.328068155288572e+01};
+  const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                       -2.549732539343734e+00,  4.374664141464968e+00,  2.938163982698783e+00};
+  const double d[4] = { 7.784695709041462e-03,  3.224671290700398e-01,  2.445134137142996e+00,
+                        3.754408661907416e+00};
+  const double p_low = 0.02425;
+  // keep away from the infinite tails
+  p = fmin(fmax(p, 1e-12), 1.0 - 1e-12);
+  if (p < p_low) {
+    double q = sqrt(-2 * log(p));
+    return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+           ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+  }
+  if (p > 1 - p_low) {
+    double q = sqrt(-2 * log(1 - p));
+    return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+            ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+  }
+  double q = p - 0.5;
+  double r = q * q;
+  return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+         (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+}
@@ -0,0 +1,46 @@
+/* 
+ * File:   GoalSampler.h
+ * Author: merbar
+ *
+ * Created on August 12, 2017, 3:20 PM
+ */
+
+#ifndef GOALSAMPLER_H
+#define GOALSAMPLER_H
+
+#include <random>
+
+using namespace std;
+
+enum SamplingMode {
+    SAMPLE_RANDOM, // independent pseudo-random draws
+    SAMPLE_HALTON  // low-discrepancy Halton points (bases 2 and 3), randomly shifted once per seed
+};
+
+// Source of normally distributed 2D perturbations for goal points.
+// Everything is derived from an explicit seed, so a planner run is reproducible.
+// Halton points cover the distribution evenly instead of clumping, so fewer samples find the same optimum.
+class GoalSampler {
+public:
+    GoalSampler(unsigned int seed = 0);
+    virtual ~GoalSampler();
+    
+    // restarts the sequence
+    void seed(unsigned int seed);
+    void set_mode(SamplingMode mode);
+    SamplingMode get_mode() const;
+    // next pair of independent N(0, std_dev) values
+    void normal_pair(double std_dev, double &x, double &y);
+    
+private:
+    static double radical_inverse(unsigned int i, unsigned int base);
+    static double inverse_normal_cdf(double p);
+    
+    SamplingMode _mode;
+    std::mt19937 _rand_generator;
+    std::normal_distribution<double> _normal;
+    unsigned int _halton_index;
+    double _halton_shift[2];
+};
+
+#endif /* GOALSAMPLER_H */
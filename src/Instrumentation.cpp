@@ -0,0 +1,102 @@
+/*
+ * File:   Instrumentation.cpp
+ * Author: merbar
+ *
+ * Created on August 14, 2017, 9:12 PM
+ */
+
+#include "Instrumentation.h"
+#include <chrono>
+#include <iomanip>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PTG_HAVE_RDTSC
+#endif
+
+static int64_t steady_ns() {
+  return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static char const *stage_names[NUM_STAGES] = {
+  "cycle", "situation", "goals", "jmt", "sampling", "evaluation",
+  "check limits", "check traffic", "check trajectory", "output", "xy conversion"
+};
+
+static char const *counter_names[NUM_COUNTERS] = {
+  "cycles", "retries", "candidates", "rejected limits", "rejected traffic", "rejected trajectory", "out of time"
+};
+
+PlannerInstrumentation &PlannerInstrumentation::instance() {
+  static PlannerInstrumentation instrumentation;
+  return instrumentation;
+}
+
+uint64_t PlannerInstrumentation::ticks() {
+#ifdef PTG_HAVE_RDTSC
+  return __rdtsc();
+#else
+  return steady_ns();
+#endif
+}
+
+PlannerInstrumentation::PlannerInstrumentation() {
+  reset();
+}
+
+void PlannerInstrumentation::reset() {
+  for (int i = 0; i < NUM_COUNTERS; i++)
+    _counters[i] = 0;
+  for (int i = 0; i < NUM_STAGES; i++) {
+    _stage_calls[i] = 0;
+    _stage_ticks[i] = 0;
+  }
+  for (int i = 0; i < MAX_COST_TERMS; i++) {
+    _cost_term_calls[i] = 0;
+    _cost_term_ticks[i] = 0;
+  }
+  _reset_ticks = ticks();
+  _reset_ns = steady_ns();
+}
+
+PlannerStats PlannerInstrumentation::snapshot() const {
+  PlannerStats stats = PlannerStats();
+#ifdef PTG_INSTRUMENTATION
+  stats.enabled = true;
+#endif
+  double elapsed_ns = double(steady_ns() - _reset_ns);
+  double elapsed_ticks = double(ticks() - _reset_ticks);
+  double ms_per_tick = (elapsed_ticks > 0) ? (1e-6 * elapsed_ns / elapsed_ticks) : 0.0;
+  stats.seconds = 1e-9 * elapsed_ns;
+  for (int i = 0; i < NUM_COUNTERS; i++)
+    stats.counters[i] = _counters[i];
+  for (int i = 0; i < NUM_STAGES; i++) {
+    stats.stage_calls[i] = _stage_calls[i];
+    stats.stage_ms[i] = ms_per_tick * _stage_ticks[i];
+  }
+  for (int i = 0; i < MAX_COST_TERMS; i++) {
+    stats.cost_term_calls[i] = _cost_term_calls[i];
+    stats.cost_term_ms[i] = ms_per_tick * _cost_term_ticks[i];
+  }
+  return stats;
+}
+
+void PlannerStats::print(ostream &out) const {
+  if (!enabled) {
+    out << "planner stats: not compiled in (PTG_INSTRUMENTATION)" << endl;
+    return;
+  }
+  out << "planner stats over " << seconds << " s" << endl;
+  for (int i = 0; i < NUM_COUNTERS; i++)
+    out << "  " << setw(20) << left << counter_names[i] << counters[i] << endl;
+  out << "  stage / calls / total ms / mean us" << endl;
+  for (int i = 0; i < NUM_STAGES; i++) {
+    double mean_us = stage_calls[i] ? (1e3 * stage_ms[i] / stage_calls[i]) : 0.0;
+    out << "  " << setw(20) << left << stage_names[i] << stage_calls[i] << " / " << stage_ms[i] << " / " << mean_us << endl;
+  }
+  out << "  cost term / calls / total ms / mean us" << endl;
+  for (int i = 0; i < num_cost_terms; i++) {
+    double mean_us = cost_term_calls[i] ? (1e3 * cost_term_ms[i] / cost_term_calls[i]) : 0.0;
+    out << "  " << setw(20) << left << cost_term_names[i] << cost_term_calls[i] << " / " << cost_term_ms[i] << " / " << mean_us << endl;
+  }
+  out << right;
+}
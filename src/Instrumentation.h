@@ -0,0 +1,152 @@
+/*
+ * File:   Instrumentation.h
+ * Author: merbar
+ *
+ * Created on August 14, 2017, 9:12 PM
+ */
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+using namespace std;
+
+// Planner counters and timers. They are only compiled in with PTG_INSTRUMENTATION,
+// otherwise the macros below expand to nothing and a snapshot stays all zero.
+
+enum PlannerStage {
+    STAGE_CYCLE,        // all of generate_trajectory()
+    STAGE_SITUATION,    // traffic around the ego vehicle, goal families to look at
+    STAGE_GOALS,        // goal generation and refinement
+    STAGE_JMT,          // jerk minimized trajectories of all goals
+    STAGE_SAMPLING,     // per-timestep samples of all trajectories
+    STAGE_EVALUATION,   // feasibility checks and cost of all trajectories
+    STAGE_CHECK_LIMITS, // within_dynamic_limits(), per candidate
+    STAGE_CHECK_TRAFFIC,    // evaluate_traffic(), per candidate
+    STAGE_CHECK_TRAJECTORY, // evaluate_trajectory(), per candidate
+    STAGE_OUTPUT,       // s/d values of the chosen trajectory
+    STAGE_XY,           // frenet to map coordinates in main
+    NUM_STAGES
+};
+
+enum PlannerCounter {
+    COUNT_CYCLES,
+    COUNT_RETRIES,          // extra iterations of the retry loop
+    COUNT_CANDIDATES,
+    COUNT_REJECT_LIMITS,    // speed, acceleration or jerk limit
+    COUNT_REJECT_TRAFFIC,   // collision found on the polynomials
+    COUNT_REJECT_TRAJECTORY, // collision or limit found on the samples
+    COUNT_OUT_OF_TIME,      // cycles that ran out of time budget without a feasible trajectory
+    NUM_COUNTERS
+};
+
+const int MAX_COST_TERMS = 16;
+
+// snapshot of everything recorded since the last reset
+struct PlannerStats {
+    bool enabled;
+    double seconds;
+    uint64_t counters[NUM_COUNTERS];
+    uint64_t stage_calls[NUM_STAGES];
+    double stage_ms[NUM_STAGES];
+    int num_cost_terms;
+    char const *cost_term_names[MAX_COST_TERMS];
+    uint64_t cost_term_calls[MAX_COST_TERMS];
+    double cost_term_ms[MAX_COST_TERMS];
+
+    void print(ostream &out = cout) const;
+};
+
+// process-wide accumulators. Safe to record into from several threads.
+class PlannerInstrumentation {
+public:
+    static PlannerInstrumentation &instance();
+
+    // cycle-accurate where the cpu has a time stamp counter, steady_clock otherwise
+    static uint64_t ticks();
+
+    void count(PlannerCounter counter, uint64_t n = 1) {
+        _counters[counter].fetch_add(n, memory_order_relaxed);
+    }
+
+    void add_stage(PlannerStage stage, uint64_t ticks) {
+        _stage_calls[stage].fetch_add(1, memory_order_relaxed);
+        _stage_ticks[stage].fetch_add(ticks, memory_order_relaxed);
+    }
+
+    void add_cost_term(int term, uint64_t ticks) {
+        _cost_term_calls[term].fetch_add(1, memory_order_relaxed);
+        _cost_term_ticks[term].fetch_add(ticks, memory_order_relaxed);
+    }
+
+    // cost term names are filled in by the caller, which knows the cost policy
+    PlannerStats snapshot() const;
+    void reset();
+
+private:
+    PlannerInstrumentation();
+
+    atomic<uint64_t> _counters[NUM_COUNTERS];
+    atomic<uint64_t> _stage_calls[NUM_STAGES];
+    atomic<uint64_t> _stage_ticks[NUM_STAGES];
+    atomic<uint64_t> _cost_term_calls[MAX_COST_TERMS];
+    atomic<uint64_t> _cost_term_ticks[MAX_COST_TERMS];
+    // ticks are converted to time by the rate observed since the last reset
+    atomic<uint64_t> _reset_ticks;
+    atomic<int64_t> _reset_ns;
+};
+
+// records the time from construction to stop() or destruction as one call of a stage
+class StageTimer {
+public:
+    StageTimer(PlannerStage stage) : _stage(stage), _start(PlannerInstrumentation::ticks()), _running(true) {}
+    ~StageTimer() {
+        stop();
+    }
+
+    void stop() {
+        if (_running)
+            PlannerInstrumentation::instance().add_stage(_stage, PlannerInstrumentation::ticks() - _start);
+        _running = false;
+    }
+
+    // result of f(), timed as one call of a stage
+    template <class F>
+    static auto timed(PlannerStage stage, F const &f) -> decltype(f()) {
+        StageTimer timer(stage);
+        return f();
+    }
+
+private:
+    PlannerStage _stage;
+    uint64_t _start;
+    bool _running;
+};
+
+#define PTG_CONCAT_(a, b) a##b
+#define PTG_CONCAT(a, b) PTG_CONCAT_(a, b)
+
+// PTG_TIME_STAGE times the rest of the enclosing scope, PTG_STAGE_BEGIN/END a named part of it
+// and PTG_TIMED a single expression.
+#ifdef PTG_INSTRUMENTATION
+#define PTG_TIME_STAGE(stage) StageTimer PTG_CONCAT(ptg_stage_timer_, __LINE__)(stage)
+#define PTG_STAGE_BEGIN(timer, stage) StageTimer timer(stage)
+#define PTG_STAGE_END(timer) timer.stop()
+#define PTG_TIMED(stage, expression) StageTimer::timed(stage, [&]() { return (expression); })
+#define PTG_COUNT(counter, n) PlannerInstrumentation::instance().count(counter, n)
+#define PTG_TICKS() PlannerInstrumentation::ticks()
+#define PTG_ADD_COST_TERM(term, ticks) PlannerInstrumentation::instance().add_cost_term(term, ticks)
+#else
+#define PTG_TIME_STAGE(stage) ((void)0)
+#define PTG_STAGE_BEGIN(timer, stage) ((void)0)
+#define PTG_STAGE_END(timer) ((void)0)
+#define PTG_TIMED(stage, expression) (expression)
+#define PTG_COUNT(counter, n) ((void)0)
+#define PTG_TICKS() uint64_t(0)
+#define PTG_ADD_COST_TERM(term, ticks) ((void)0)
+#endif
+
+#endif /* INSTRUMENTATION_H */
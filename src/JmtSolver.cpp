@@ -0,0 +1,51 @@
+/* 
+ * File:   JmtSolver.cpp
+ * Author: merbar
+ * 
+ * Created on August 6, 2017, 6:40 PM
+ */
+
+#include "JmtSolver.h"
+
+JmtSolver::JmtSolver() {
+  _horizon = 0;
+  _A_inv.setZero();
+}
+
+JmtSolver::~JmtSolver() {
+}
+
+// closed-form inverse of
+// | T^3   T^4    T^5  |
+// | 3T^2  4T^3   5T^4 |
+// | 6T    12T^2  20T^3|
+// which is far better conditioned than inverting it numerically for horizons of a few hundred timesteps
+void JmtSolver::set_horizon(int horizon) {
+  if (horizon == _horizon)
+    return;
+  _horizon = horizon;
+  double T = double(horizon);
+  double t_2 = T * T;
+  double t_3 = t_2 * T;
+  double t_4 = t_3 * T;
+  double t_5 = t_4 * T;
+  _A_inv << 10.0 / t_3,  -4.0 / t_2,  0.5 / T,
+           -15.0 / t_4,   7.0 / t_3, -1.0 / t_2,
+             6.0 / t_5,  -3.0 / t_4,  0.5 / t_3;
+}
+
+void JmtSolver::solve(vector<double> const &start, GoalMatrix const &goals, int count, CoefficientMatrix &coeffs) const {
+  double T = double(_horizon);
+  Eigen::Vector3d b_start;
+  b_start << start[0] + start[1] * T + 0.5 * start[2] * T * T,
+             start[1] + start[2] * T,
+             start[2];
+  if (coeffs.cols() < count)
+    coeffs.resize(6, count);
+  coeffs.block(0, 0, 1, count).setConstant(start[0]);
+  coeffs.block(1, 0, 1, count).setConstant(start[1]);
+  coeffs.block(2, 0, 1, count).setConstant(0.5 * start[2]);
+  // column by column, fixed-size products never take a temporary from the heap
+  for (int i = 0; i < count; i++)
+    coeffs.block<3, 1>(3, i).noalias() = _A_inv * (goals.col(i) - b_start);
+}
@@ -0,0 +1,39 @@
+/* 
+ * File:   JmtSolver.h
+ * Author: merbar
+ *
+ * Created on August 6, 2017, 6:40 PM
+ */
+
+#ifndef JMTSOLVER_H
+#define JMTSOLVER_H
+
+#include <vector>
+#include "Eigen-3.3/Eigen/Core"
+#include "TimeBasis.h"
+
+using namespace std;
+
+// goal states of a batch of trajectories. One column {pos, vel, acc} per goal.
+typedef Eigen::Matrix<double, 3, Eigen::Dynamic> GoalMatrix;
+
+// Jerk minimized trajectories for a fixed time horizon.
+// The system matrix only depends on the horizon, so its (closed-form) inverse is
+// cached and all goals of a cycle are solved with a single 3xN product.
+class JmtSolver {
+public:
+    JmtSolver();
+    virtual ~JmtSolver();
+    
+    // recomputes the cached inverse only if the horizon changed
+    void set_horizon(int horizon);
+    // start is {pos, vel, acc}. One column of coeffs for each of the first count columns of goals.
+    // coeffs is only reallocated if it has less than count columns.
+    void solve(vector<double> const &start, GoalMatrix const &goals, int count, CoefficientMatrix &coeffs) const;
+    
+private:
+    int _horizon;
+    Eigen::Matrix3d _A_inv;
+};
+
+#endif /* JMTSOLVER_H */
@@ -0,0 +1,193 @@
+/*
+ * File:   Map.cpp
+ * Author: merbar
+ *
+ * Created on August 20, 2017, 4:10 PM
+ */
+
+#include "Map.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <math.h>
+
+static double distance(double x1, double y1, double x2, double y2) {
+  return sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+}
+
+Map::Map() {
+}
+
+Map::~Map() {
+}
+
+bool Map::load(string const &file_name) {
+  ifstream in_map_(file_name.c_str(), ifstream::in);
+
+  string line;
+  bool zero_s_encountered = false;
+  while (getline(in_map_, line)) {
+    istringstream iss(line);
+    double x;
+    double y;
+    float s;
+    float d_x;
+    float d_y;
+    iss >> x;
+    iss >> y;
+    iss >> s;
+    iss >> d_x;
+    iss >> d_y;
+
+    // cut off erroneous data in csv
+    if (s == 0) {
+      if (zero_s_encountered == true) {
+        break;
+      } else {
+        zero_s_encountered = true;
+      }
+    }
+    add_waypoint(x, y, s, d_x, d_y);
+  }
+  build_index();
+  return size() > 0;
+}
+
+void Map::add_waypoint(double x, double y, double s, double dx, double dy) {
+  _x.push_back(x);
+  _y.push_back(y);
+  _s.push_back(s);
+  _dx.push_back(dx);
+  _dy.push_back(dy);
+}
+
+void Map::build_index() {
+  _tree.resize(size());
+  for (int i = 0; i < size(); i++)
+    _tree[i] = i;
+  build_tree(0, size(), 0);
+  // summed in the same order as walking the waypoints would
+  _arc_length.resize(size());
+  for (int i = 0; i < size(); i++)
+    _arc_length[i] = (i == 0) ? 0.0 : _arc_length[i - 1] + distance(_x[i - 1], _y[i - 1], _x[i], _y[i]);
+}
+
+int Map::size() const {
+  return _x.size();
+}
+
+vector<double> const &Map::x() const {
+  return _x;
+}
+
+vector<double> const &Map::y() const {
+  return _y;
+}
+
+vector<double> const &Map::s() const {
+  return _s;
+}
+
+vector<double> const &Map::dx() const {
+  return _dx;
+}
+
+vector<double> const &Map::dy() const {
+  return _dy;
+}
+
+int Map::closest_waypoint(double x, double y) const {
+  double closestLen = 100000; //large number
+  int closestWaypoint = 0;
+  search_tree(0, _tree.size(), 0, x, y, closestWaypoint, closestLen);
+  return closestWaypoint;
+}
+
+int Map::next_waypoint(double x, double y, double theta) const {
+  int closestWaypoint = closest_waypoint(x, y);
+
+  double map_x = _x[closestWaypoint];
+  double map_y = _y[closestWaypoint];
+
+  double heading = atan2((map_y - y), (map_x - x));
+
+  double angle = abs(theta - heading);
+
+  // the waypoint after the last one is the first one
+  if (angle > M_PI / 4)
+    closestWaypoint = (closestWaypoint + 1) % size();
+
+  return closestWaypoint;
+}
+
+double Map::arc_length(int i) const {
+  return _arc_length[i];
+}
+
+void Map::frenet(double x, double y, double theta, double &s, double &d) const {
+  int next_wp = next_waypoint(x, y, theta);
+
+  int prev_wp;
+  prev_wp = next_wp - 1;
+  if (next_wp == 0)
+    prev_wp = size() - 1;
+
+  double n_x = _x[next_wp] - _x[prev_wp];
+  double n_y = _y[next_wp] - _y[prev_wp];
+  double x_x = x - _x[prev_wp];
+  double x_y = y - _y[prev_wp];
+
+  // find the projection of x onto n
+  double proj_norm = (x_x * n_x + x_y * n_y) / (n_x * n_x + n_y * n_y);
+  double proj_x = proj_norm * n_x;
+  double proj_y = proj_norm * n_y;
+
+  d = distance(x_x, x_y, proj_x, proj_y);
+
+  //see if d value is positive or negative by comparing it to a center point
+  double center_x = 1000 - _x[prev_wp];
+  double center_y = 2000 - _y[prev_wp];
+  double centerToPos = distance(center_x, center_y, x_x, x_y);
+  double centerToRef = distance(center_x, center_y, proj_x, proj_y);
+
+  if (centerToPos <= centerToRef)
+    d *= -1;
+
+  s = _arc_length[prev_wp] + distance(0, 0, proj_x, proj_y);
+}
+
+void Map::build_tree(int begin, int end, int axis) {
+  if (end - begin < 2)
+    return;
+  int mid = (begin + end) / 2;
+  vector<double> const &key = axis ? _y : _x;
+  std::nth_element(_tree.begin() + begin, _tree.begin() + mid, _tree.begin() + end, [&key](int a, int b) {
+    return key[a] < key[b];
+  });
+  build_tree(begin, mid, 1 - axis);
+  build_tree(mid + 1, end, 1 - axis);
+}
+
+// Ties go to the lower waypoint index, like a linear scan would.
+void Map::search_tree(int begin, int end, int axis, double x, double y, int &best, double &best_dist) const {
+  if (begin >= end)
+    return;
+  int mid = (begin + end) / 2;
+  int i = _tree[mid];
+  double dist = sqrt((_x[i] - x) * (_x[i] - x) + (_y[i] - y) * (_y[i] - y));
+  if ((dist < best_dist) || ((dist == best_dist) && (i < best))) {
+    best = i;
+    best_dist = dist;
+  }
+  double offset = axis ? (y - _y[i]) : (x - _x[i]);
+  // the side of the split the query is on first, the other one only if it can hold something as close
+  if (offset < 0) {
+    search_tree(begin, mid, 1 - axis, x, y, best, best_dist);
+    if (-offset <= best_dist)
+      search_tree(mid + 1, end, 1 - axis, x, y, best, best_dist);
+  } else {
+    search_tree(mid + 1, end, 1 - axis, x, y, best, best_dist);
+    if (offset <= best_dist)
+      search_tree(begin, mid, 1 - axis, x, y, best, best_dist);
+  }
+}
@@ -0,0 +1,62 @@
+/*
+ * File:   Map.h
+ * Author: merbar
+ *
+ * Created on August 20, 2017, 4:10 PM
+ */
+
+#ifndef MAP_H
+#define MAP_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Waypoints of the track: x, y, s and the normalized normal vector dx, dy of every one of them.
+// Loaded once at startup, together with a k-d tree over x/y for nearest waypoint queries.
+class Map {
+public:
+    Map();
+    virtual ~Map();
+
+    // reads "x y s dx dy" lines. Returns false if the file has no waypoints.
+    bool load(string const &file_name);
+    void add_waypoint(double x, double y, double s, double dx, double dy);
+    // has to be called once all waypoints are added. Builds the k-d tree and the arc-length table.
+    void build_index();
+
+    int size() const;
+    vector<double> const &x() const;
+    vector<double> const &y() const;
+    vector<double> const &s() const;
+    vector<double> const &dx() const;
+    vector<double> const &dy() const;
+
+    // O(log n) on average
+    int closest_waypoint(double x, double y) const;
+    // first waypoint ahead of a position heading in direction theta
+    int next_waypoint(double x, double y, double theta) const;
+    // length of the polyline from the first waypoint to waypoint i
+    double arc_length(int i) const;
+
+    // Cartesian x,y to Frenet s,d. Constant time after the waypoint lookup.
+    void frenet(double x, double y, double theta, double &s, double &d) const;
+
+private:
+    void build_tree(int begin, int end, int axis);
+    void search_tree(int begin, int end, int axis, double x, double y, int &best, double &best_dist) const;
+
+    vector<double> _x;
+    vector<double> _y;
+    vector<double> _s;
+    vector<double> _dx;
+    vector<double> _dy;
+    // prefix sums of the distances between consecutive waypoints
+    vector<double> _arc_length;
+    // implicit k-d tree of waypoint indices: the median of [begin, end) splits it on x, then y, and so on
+    vector<int> _tree;
+};
+
+#endif /* MAP_H */
+
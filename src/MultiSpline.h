@@ -0,0 +1,257 @@
+/*
+ * File:   MultiSpline.h
+ * Author: merbar
+ *
+ * Created on August 22, 2017, 7:15 PM
+ */
+
+#ifndef MULTISPLINE_H
+#define MULTISPLINE_H
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+
+using namespace std;
+
+// Cubic splines of several series over the same knots, e.g. x, y, dx and dy of a track over s.
+// The tridiagonal system only depends on the knots, so it is factorized once (Thomas algorithm)
+// and all series are solved with it together. A periodic fit closes the cyclic system with
+// Sherman-Morrison, which needs one more solve with the same factorization.
+// Coefficients are stored interleaved per interval, so evaluating all series at a point reads
+// one contiguous block next to each other instead of one per series.
+template <int Series>
+class MultiSpline {
+public:
+    typedef array<double, Series> Values;
+
+    MultiSpline() : _period(0) {
+    }
+
+    // Knots have to be strictly increasing, values holds all series at every knot.
+    // A period > 0 makes the fit periodic: the knot after the last one is the first one at x[0] + period.
+    // Without, the ends have zero curvature and the splines are extended linearly past them.
+    void fit(vector<double> const &x, vector<Values> const &values, double period = 0) {
+        int n = x.size();
+        assert(n == (int)values.size());
+        assert(n > 2);
+        assert((period <= 0) || (x[0] + period > x[n - 1]));
+        _x = x;
+        _period = period;
+        bool periodic = (period > 0);
+        // width of every interval, the one closing the loop last
+        vector<double> h(n);
+        for (int i = 0; i < n - 1; i++) {
+            assert(x[i] < x[i + 1]);
+            h[i] = x[i + 1] - x[i];
+        }
+        h[n - 1] = periodic ? x[0] + period - x[n - 1] : 0.0;
+
+        // b (half the second derivative) at every knot from
+        // h[i-1]/3 b[i-1] + 2/3 (h[i-1] + h[i]) b[i] + h[i]/3 b[i+1] = slope[i] - slope[i-1]
+        vector<double> lower(n), diag(n), upper(n);
+        vector<Values> rhs(n);
+        for (int i = 0; i < n; i++) {
+            bool boundary = !periodic && ((i == 0) || (i == n - 1));
+            int prev = (i + n - 1) % n;
+            int next = (i + 1) % n;
+            if (boundary) {
+                // zero curvature
+                lower[i] = 0.0;
+                diag[i] = 2.0;
+                upper[i] = 0.0;
+                rhs[i].fill(0.0);
+                continue;
+            }
+            lower[i] = h[prev] / 3.0;
+            diag[i] = 2.0 / 3.0 * (h[prev] + h[i]);
+            upper[i] = h[i] / 3.0;
+            for (int k = 0; k < Series; k++)
+                rhs[i][k] = (values[next][k] - values[i][k]) / h[i] - (values[i][k] - values[prev][k]) / h[prev];
+        }
+
+        vector<Values> b;
+        if (!periodic) {
+            factorize(lower, diag, upper);
+            solve(lower, diag, upper, rhs, b);
+        } else {
+            // The cyclic matrix is the tridiagonal one plus u v^T with u = (gamma, 0, ..., 0, upper[n-1])
+            // and v = (1, 0, ..., 0, lower[0] / gamma). Both corners move onto the diagonal.
+            double corner_top = lower[0];
+            double corner_bottom = upper[n - 1];
+            double gamma = -diag[0];
+            diag[0] -= gamma;
+            diag[n - 1] -= corner_bottom * corner_top / gamma;
+            factorize(lower, diag, upper);
+            solve(lower, diag, upper, rhs, b);
+            vector<array<double, 1> > u(n), z;
+            for (int i = 0; i < n; i++)
+                u[i][0] = 0.0;
+            u[0][0] = gamma;
+            u[n - 1][0] = corner_bottom;
+            solve(lower, diag, upper, u, z);
+            double v_z = z[0][0] + corner_top * z[n - 1][0] / gamma;
+            for (int k = 0; k < Series; k++) {
+                double v_b = b[0][k] + corner_top * b[n - 1][k] / gamma;
+                double factor = v_b / (1.0 + v_z);
+                for (int i = 0; i < n; i++)
+                    b[i][k] -= factor * z[i][0];
+            }
+        }
+
+        // coefficients of every interval. The last one closes the loop, or extends the spline linearly.
+        _coeff.resize(n);
+        for (int i = 0; i < n; i++) {
+            int next = (i + 1) % n;
+            Coefficients &c = _coeff[i];
+            for (int k = 0; k < Series; k++) {
+                c.y[k] = values[i][k];
+                if (periodic || (i < n - 1)) {
+                    c.a[k] = (b[next][k] - b[i][k]) / (3.0 * h[i]);
+                    c.b[k] = b[i][k];
+                    c.c[k] = (values[next][k] - values[i][k]) / h[i] - (2.0 * b[i][k] + b[next][k]) * h[i] / 3.0;
+                } else {
+                    double h_last = h[n - 2];
+                    Coefficients const &last = _coeff[n - 2];
+                    c.a[k] = 0.0;
+                    c.b[k] = 0.0;
+                    c.c[k] = (3.0 * last.a[k] * h_last + 2.0 * last.b[k]) * h_last + last.c[k];
+                }
+            }
+        }
+    }
+
+    int num_knots() const {
+        return _x.size();
+    }
+
+    bool periodic() const {
+        return _period > 0;
+    }
+
+    // all series at x
+    void eval(double x, double *y) const {
+        x = wrap(x);
+        int i = interval(x);
+        eval(_coeff[i], x - _x[i], i, y);
+    }
+
+    // first or second derivative of all series at x
+    void deriv(int order, double x, double *y) const {
+        assert((order == 1) || (order == 2));
+        x = wrap(x);
+        int i = interval(x);
+        Coefficients const &c = _coeff[i];
+        double h = x - _x[i];
+        bool left_extension = (h < 0) && (i == 0) && !periodic();
+        for (int k = 0; k < Series; k++) {
+            if (order == 1)
+                y[k] = left_extension ? c.c[k] : (3.0 * c.a[k] * h + 2.0 * c.b[k]) * h + c.c[k];
+            else
+                y[k] = left_extension ? 0.0 : 6.0 * c.a[k] * h + 2.0 * c.b[k];
+        }
+    }
+
+    // all series at n points, y[i * Series + k] is series k at x[i]. For x in increasing order the
+    // interval of a point is found by walking on from the one of the previous point.
+    void eval(double const *x, int n, double *y) const {
+        int first = -1;
+        eval(x, n, y, first);
+    }
+
+    // the same, starting the walk at interval first instead of a search, e.g. the one the previous call
+    // started in when x moves along slowly between calls. first is set to the interval of x[0].
+    void eval(double const *x, int n, double *y, int &first) const {
+        int i = first;
+        for (int p = 0; p < n; p++) {
+            double x_p = wrap(x[p]);
+            i = interval(x_p, i);
+            if (p == 0)
+                first = i;
+            eval(_coeff[i], x_p - _x[i], i, y + p * Series);
+        }
+    }
+
+private:
+    // interleaved per interval: f_k(x) = ((a[k] h + b[k]) h + c[k]) h + y[k] with h = x - x_i
+    struct Coefficients {
+        double y[Series];
+        double c[Series];
+        double b[Series];
+        double a[Series];
+    };
+
+    // Thomas algorithm, in place: upper becomes the upper diagonal of U with a unit diagonal,
+    // diag the inverse pivots
+    static void factorize(vector<double> const &lower, vector<double> &diag, vector<double> &upper) {
+        int n = diag.size();
+        for (int i = 0; i < n; i++) {
+            double pivot = diag[i] - ((i > 0) ? lower[i] * upper[i - 1] : 0.0);
+            assert(pivot != 0.0);
+            diag[i] = 1.0 / pivot;
+            upper[i] *= diag[i];
+        }
+    }
+
+    // forward and back substitution with a factorized matrix, for all columns of rhs at once
+    template <size_t Columns>
+    static void solve(vector<double> const &lower, vector<double> const &diag, vector<double> const &upper,
+                      vector<array<double, Columns> > const &rhs, vector<array<double, Columns> > &x) {
+        int n = rhs.size();
+        x.resize(n);
+        for (int i = 0; i < n; i++) {
+            for (int k = 0; k < (int)Columns; k++)
+                x[i][k] = (rhs[i][k] - ((i > 0) ? lower[i] * x[i - 1][k] : 0.0)) * diag[i];
+        }
+        for (int i = n - 2; i >= 0; i--) {
+            for (int k = 0; k < (int)Columns; k++)
+                x[i][k] -= upper[i] * x[i + 1][k];
+        }
+    }
+
+    double wrap(double x) const {
+        if (_period <= 0)
+            return x;
+        x = _x[0] + fmod(x - _x[0], _period);
+        return (x < _x[0]) ? x + _period : x;
+    }
+
+    // closest knot below x, 0 even if x is left of the first knot
+    int interval(double x) const {
+        return max(int(lower_bound(_x.begin(), _x.end(), x) - _x.begin()) - 1, 0);
+    }
+
+    // the same, walking on from interval from if x is a few knots ahead of it. Searches otherwise.
+    int interval(double x, int from) const {
+        static const int max_walk = 4;
+        int n_knots = _x.size();
+        if ((from < 0) || (from >= n_knots) || ((from > 0) && (x <= _x[from])))
+            return interval(x);
+        for (int step = 0; (from < n_knots - 1) && (_x[from + 1] < x); step++) {
+            if (step == max_walk)
+                return interval(x);
+            from++;
+        }
+        return from;
+    }
+
+    void eval(Coefficients const &c, double h, int i, double *y) const {
+        if ((h < 0) && (i == 0) && !periodic()) {
+            // linear extension to the left, the second derivative is zero at the end
+            for (int k = 0; k < Series; k++)
+                y[k] = c.c[k] * h + c.y[k];
+            return;
+        }
+        for (int k = 0; k < Series; k++)
+            y[k] = ((c.a[k] * h + c.b[k]) * h + c.c[k]) * h + c.y[k];
+    }
+
+    vector<double> _x;
+    vector<Coefficients> _coeff;
+    double _period;
+};
+
+#endif /* MULTISPLINE_H */
+
@@ -14,33 +14,222 @@
 #ifndef POLYNOMIAL_H
 #define POLYNOMIAL_H
 
+#include <array>
 #include <vector>
 #include <iostream>
+#include <type_traits>
 #include <math.h>
 
 using namespace std;
 
+// Fixed-degree polynomial. Coefficients are stored in increasing order (c0 + c1*x + ...)
+// in a plain array so that instances are trivially copyable and need no heap memory.
+// All evaluation uses Horner's scheme.
+template <int Degree> class Polynomial;
+
+// real roots of a polynomial inside an interval, see Polynomial::real_roots()
+template <int Degree> struct PolynomialRoots;
+
+template <int Degree>
 class Polynomial {
 public:
-    Polynomial();
-    Polynomial(const Polynomial& orig);
-    Polynomial(vector<double> const &coefficients);
-    virtual ~Polynomial();
+    static const int num_coeff = Degree + 1;
+
+    Polynomial() {
+        _coeff.fill(0.0);
+    }
+    
+    Polynomial(vector<double> const &coefficients) {
+        set(coefficients);
+    }
+    
+    // widens a polynomial of lower degree
+    template <int OtherDegree>
+    explicit Polynomial(Polynomial<OtherDegree> const &other) {
+        static_assert(OtherDegree <= Degree, "Polynomial can only be widened");
+        for (int i = 0; i < num_coeff; i++)
+            _coeff[i] = (i <= OtherDegree) ? other[i] : 0.0;
+    }
+    
+    Polynomial(double const *coefficients) {
+        for (int i = 0; i < num_coeff; i++)
+            _coeff[i] = coefficients[i];
+    }
+    
+    // missing higher order coefficients are zero
+    void set(vector<double> const &coefficients) {
+        for (int i = 0; i < num_coeff; i++)
+            _coeff[i] = (i < (int)coefficients.size()) ? coefficients[i] : 0.0;
+    }
+    
+    double eval(double x) const {
+        double result = _coeff[Degree];
+        for (int i = Degree - 1; i >= 0; i--)
+            result = result * x + _coeff[i];
+        return result;
+    }
+    
+    double eval_d(double x) const {
+        double result = 0.0;
+        for (int i = Degree; i >= 1; i--)
+            result = result * x + i * _coeff[i];
+        return result;
+    }
+    
+    double eval_double_d(double x) const {
+        double result = 0.0;
+        for (int i = Degree; i >= 2; i--)
+            result = result * x + i * (i - 1) * _coeff[i];
+        return result;
+    }
+    
+    double eval_triple_d(double x) const {
+        double result = 0.0;
+        for (int i = Degree; i >= 3; i--)
+            result = result * x + i * (i - 1) * (i - 2) * _coeff[i];
+        return result;
+    }
+    
+    Polynomial<(Degree > 0 ? Degree - 1 : 0)> derivative() const {
+        Polynomial<(Degree > 0 ? Degree - 1 : 0)> result;
+        for (int i = 1; i <= Degree; i++)
+            result[i - 1] = i * _coeff[i];
+        return result;
+    }
+    
+    Polynomial operator+(Polynomial const &other) const {
+        Polynomial result;
+        for (int i = 0; i < num_coeff; i++)
+            result._coeff[i] = _coeff[i] + other._coeff[i];
+        return result;
+    }
+    
+    Polynomial operator-(Polynomial const &other) const {
+        Polynomial result;
+        for (int i = 0; i < num_coeff; i++)
+            result._coeff[i] = _coeff[i] - other._coeff[i];
+        return result;
+    }
     
-    void set(vector<double> const &coefficients);
-    double eval(double x) const;
-    double eval_d(double x) const;
-    double eval_double_d(double x) const;
-    double eval_triple_d(double x) const;
-    void print() const;
+    Polynomial operator-(double value) const {
+        Polynomial result = *this;
+        result._coeff[0] -= value;
+        return result;
+    }
     
+    // writes the real roots inside [lo, hi] in increasing order to roots
+    // (room for Degree values) and returns how many were found
+    int real_roots(double lo, double hi, double *roots) const {
+        return PolynomialRoots<Degree>::find(*this, lo, hi, roots);
+    }
+    
+    // smallest and largest value on [lo, hi], found at the ends or where the derivative vanishes
+    void bounds(double lo, double hi, double &p_min, double &p_max) const {
+        double critical[Degree > 1 ? Degree - 1 : 1];
+        int num_critical = derivative().real_roots(lo, hi, critical);
+        p_min = min(eval(lo), eval(hi));
+        p_max = max(eval(lo), eval(hi));
+        for (int i = 0; i < num_critical; i++) {
+            double p_c = eval(critical[i]);
+            p_min = min(p_min, p_c);
+            p_max = max(p_max, p_c);
+        }
+    }
+    
+    double &operator[](int i) {
+        return _coeff[i];
+    }
+    
+    double operator[](int i) const {
+        return _coeff[i];
+    }
+    
+    void print() const {
+        cout << "Polynomial Coefficients: "<< endl;
+        for (double x : _coeff)
+            cout << x << " :: ";
+        cout << endl;
+    }
     
 private:
-    vector<double> _coeff;
-    vector<double> _coeff_d;
-    vector<double> _coeff_double_d;
-    vector<double> _coeff_triple_d;
+    array<double, Degree + 1> _coeff;
 };
 
-#endif /* POLYNOMIAL_H */
+// The roots of the derivative split [lo, hi] into pieces on which the polynomial is monotonic.
+// Every piece holds at most one root, which is then polished by Newton's method, safeguarded by bisection.
+template <int Degree>
+struct PolynomialRoots {
+    static int find(Polynomial<Degree> const &p, double lo, double hi, double *roots) {
+        Polynomial<Degree - 1> p_d = p.derivative();
+        double critical[Degree > 1 ? Degree - 1 : 1];
+        int num_critical = p_d.real_roots(lo, hi, critical);
+        int num_roots = 0;
+        double a = lo;
+        double p_a = p.eval(a);
+        if (p_a == 0.0)
+            roots[num_roots++] = a;
+        for (int i = 0; i <= num_critical; i++) {
+            double b = (i < num_critical) ? critical[i] : hi;
+            double p_b = p.eval(b);
+            if (p_b == 0.0) {
+                if ((num_roots == 0) || (roots[num_roots - 1] < b))
+                    roots[num_roots++] = b;
+            } else if ((p_a != 0.0) && ((p_a < 0.0) != (p_b < 0.0))) {
+                roots[num_roots++] = polish(p, p_d, a, b, p_a < 0.0);
+            }
+            a = b;
+            p_a = p_b;
+        }
+        return num_roots;
+    }
+    
+    // root of p inside the bracket [l, r] over which p is monotonic
+    static double polish(Polynomial<Degree> const &p, Polynomial<Degree - 1> const &p_d, double l, double r, bool negative_at_l) {
+        double x = 0.5 * (l + r);
+        for (int iter = 0; iter < 100; iter++) {
+            double p_x = p.eval(x);
+            if (p_x == 0.0)
+                return x;
+            if ((p_x < 0.0) == negative_at_l)
+                l = x;
+            else
+                r = x;
+            double slope = p_d.eval(x);
+            double next = (slope != 0.0) ? x - p_x / slope : l;
+            // fall back to bisection whenever Newton leaves the bracket
+            if ((next <= l) || (next >= r))
+                next = 0.5 * (l + r);
+            if ((abs(next - x) <= 1e-12 * (1.0 + abs(x))) || (next <= l) || (next >= r))
+                return next;
+            x = next;
+        }
+        return x;
+    }
+};
 
+template <>
+struct PolynomialRoots<1> {
+    static int find(Polynomial<1> const &p, double lo, double hi, double *roots) {
+        if (p[1] == 0.0)
+            return 0;
+        double root = -p[0] / p[1];
+        if ((root < lo) || (root > hi))
+            return 0;
+        roots[0] = root;
+        return 1;
+    }
+};
+
+template <>
+struct PolynomialRoots<0> {
+    static int find(Polynomial<0> const &, double, double, double *) {
+        return 0;
+    }
+};
+
+// jerk minimized trajectories
+typedef Polynomial<5> QuinticPolynomial;
+
+static_assert(is_trivially_copyable<QuinticPolynomial>::value, "QuinticPolynomial must stay trivially copyable");
+
+#endif /* POLYNOMIAL_H */
@@ -0,0 +1,52 @@
+/*
+ * File:   SpeedProfile.cpp
+ * Author: merbar
+ *
+ * Created on August 23, 2017, 5:40 PM
+ */
+
+#include "SpeedProfile.h"
+#include <algorithm>
+#include <math.h>
+
+SpeedProfile::SpeedProfile() : _track(NULL), _step(1.0), _num_samples(0) {
+}
+
+SpeedProfile::~SpeedProfile() {
+}
+
+void SpeedProfile::build(Track const &track, double lane_width, double step) {
+  _track = &track;
+  _step = step;
+  _num_samples = int(ceil(track.length() / step)) + 1;
+  _curvature.resize(_num_samples);
+  _scale.resize(_num_samples * num_lanes);
+  for (int i = 0; i < _num_samples; i++) {
+    double s = i * step;
+    _curvature[i] = track.curvature(s);
+    for (int lane = 0; lane < num_lanes; lane++) {
+      double d = (lane + 0.5) * lane_width;
+      _scale[i * num_lanes + lane] = min(1.0, 1.0 / track.offset_ratio(s, d));
+    }
+  }
+}
+
+int SpeedProfile::index(double s) const {
+  int i = int(floor(_track->wrap(s) / _step + 0.5));
+  return max(0, min(i, _num_samples - 1));
+}
+
+double SpeedProfile::scale(int lane, double s) const {
+  return _scale[index(s) * num_lanes + lane];
+}
+
+double SpeedProfile::scale(int lane, double s_begin, double s_end) const {
+  double lowest = 1.0;
+  for (double s = s_begin; s <= s_end; s += _step)
+    lowest = min(lowest, scale(lane, s));
+  return min(lowest, scale(lane, s_end));
+}
+
+double SpeedProfile::curvature(double s) const {
+  return _curvature[index(s)];
+}
@@ -0,0 +1,49 @@
+/*
+ * File:   SpeedProfile.h
+ * Author: merbar
+ *
+ * Created on August 23, 2017, 5:40 PM
+ */
+
+#ifndef SPEEDPROFILE_H
+#define SPEEDPROFILE_H
+
+#include <vector>
+#include "Track.h"
+
+using namespace std;
+
+// Speed limit of every lane along the whole track, computed once at startup.
+// The planner works in Frenet s, which is measured on the centerline. On the outside of a turn a lane
+// is longer than the centerline, so driving the limit in s is faster than the limit. The profile holds,
+// every step meters of s, the fraction of the limit that is the limit in s for every lane.
+class SpeedProfile {
+public:
+    static const int num_lanes = 3;
+
+    SpeedProfile();
+    virtual ~SpeedProfile();
+
+    void build(Track const &track, double lane_width = 4.0, double step = 1.0);
+
+    // fraction of the speed limit to plan with in a lane at s. At most 1, lanes on the inside of a turn
+    // aren't allowed to go faster.
+    double scale(int lane, double s) const;
+    // lowest scale between s_begin and s_end, e.g. over everything the planning horizon can reach
+    double scale(int lane, double s_begin, double s_end) const;
+    // curvature of the centerline at s, at the resolution of the profile
+    double curvature(double s) const;
+
+private:
+    int index(double s) const;
+
+    Track const *_track;
+    double _step;
+    int _num_samples;
+    vector<double> _curvature;
+    // num_lanes values per sample
+    vector<double> _scale;
+};
+
+#endif /* SPEEDPROFILE_H */
+
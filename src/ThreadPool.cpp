@@ -0,0 +1,122 @@
+/* 
+ * File:   ThreadPool.cpp
+ * Author: merbar
+ * 
+ * Created on August 10, 2017, 7:55 PM
+ */
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int num_threads) : _queues(max(num_threads, 1)) {
+  _stop = false;
+  _generation = 0;
+  _busy_workers = 0;
+  _invoker = nullptr;
+  _body = nullptr;
+  _count = 0;
+  _chunk_size = 1;
+  for (int i = 0; i < (int)_queues.size(); i++) {
+    _queues[i].head = 0;
+    _queues[i].tail = 0;
+  }
+  // queue 0 belongs to the calling thread
+  for (int i = 1; i < (int)_queues.size(); i++)
+    _workers.push_back(thread(&ThreadPool::worker_loop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    unique_lock<mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (int i = 0; i < (int)_workers.size(); i++)
+    _workers[i].join();
+}
+
+int ThreadPool::size() const {
+  return _queues.size();
+}
+
+void ThreadPool::run(int count, Invoker invoker, void const *body) {
+  if ((_workers.size() == 0) || (count <= 1)) {
+    for (int i = 0; i < count; i++)
+      invoker(body, i);
+    return;
+  }
+  {
+    unique_lock<mutex> lock(_mutex);
+    _invoker = invoker;
+    _body = body;
+    _count = count;
+    // a few chunks per thread leave room for balancing by stealing
+    int num_queues = _queues.size();
+    int target_chunks = num_queues * 4;
+    _chunk_size = (count + target_chunks - 1) / target_chunks;
+    int num_chunks = (count + _chunk_size - 1) / _chunk_size;
+    // contiguous blocks of chunks per queue
+    for (int i = 0; i < num_queues; i++) {
+      unique_lock<mutex> queue_lock(_queues[i].lock);
+      _queues[i].head = (num_chunks * i) / num_queues;
+      _queues[i].tail = (num_chunks * (i + 1)) / num_queues;
+    }
+    _busy_workers = _workers.size();
+    _generation++;
+  }
+  _wake.notify_all();
+  work(0);
+  unique_lock<mutex> lock(_mutex);
+  _done.wait(lock, [this] { return _busy_workers == 0; });
+}
+
+void ThreadPool::worker_loop(int id) {
+  int seen_generation = 0;
+  while (true) {
+    {
+      unique_lock<mutex> lock(_mutex);
+      _wake.wait(lock, [this, seen_generation] { return _stop || (_generation != seen_generation); });
+      if (_stop)
+        return;
+      seen_generation = _generation;
+    }
+    work(id);
+    {
+      unique_lock<mutex> lock(_mutex);
+      _busy_workers--;
+      if (_busy_workers == 0)
+        _done.notify_one();
+    }
+  }
+}
+
+void ThreadPool::work(int id) {
+  int chunk;
+  while (take_chunk(id, chunk)) {
+    int begin = chunk * _chunk_size;
+    int end = min(_count, begin + _chunk_size);
+    for (int i = begin; i < end; i++)
+      _invoker(_body, i);
+  }
+}
+
+// own queue from the back, then steal from the front of the others
+bool ThreadPool::take_chunk(int id, int &chunk) {
+  {
+    unique_lock<mutex> lock(_queues[id].lock);
+    if (_queues[id].head < _queues[id].tail) {
+      _queues[id].tail--;
+      chunk = _queues[id].tail;
+      return true;
+    }
+  }
+  for (int offset = 1; offset < (int)_queues.size(); offset++) {
+    WorkQueue &victim = _queues[(id + offset) % _queues.size()];
+    unique_lock<mutex> lock(victim.lock);
+    if (victim.head < victim.tail) {
+      chunk = victim.head;
+      victim.head++;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,70 @@
+/* 
+ * File:   ThreadPool.h
+ * Author: merbar
+ *
+ * Created on August 10, 2017, 7:55 PM
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Persistent pool of worker threads for data-parallel loops.
+// A loop is cut into chunks that are dealt out to one queue per thread up front. Threads work their
+// own queue from the back and steal from the front of the others' once it runs dry.
+// Threads are created once, and running a loop allocates nothing.
+class ThreadPool {
+public:
+    // num_threads includes the calling thread, which always takes part in a loop
+    ThreadPool(int num_threads);
+    virtual ~ThreadPool();
+    
+    int size() const;
+    // calls body(i) for every i in [0, count) and returns once all calls are done.
+    // Calls for different i may run concurrently.
+    template <class Body>
+    void parallel_for(int count, Body const &body) {
+        run(count, &invoke<Body>, &body);
+    }
+    
+private:
+    typedef void (*Invoker)(void const *body, int i);
+    
+    template <class Body>
+    static void invoke(void const *body, int i) {
+        (*static_cast<Body const *>(body))(i);
+    }
+    
+    struct WorkQueue {
+        mutex lock;
+        int head;
+        int tail;
+    };
+    
+    void run(int count, Invoker invoker, void const *body);
+    void worker_loop(int id);
+    void work(int id);
+    bool take_chunk(int id, int &chunk);
+    
+    vector<thread> _workers;
+    vector<WorkQueue> _queues;
+    mutex _mutex;
+    condition_variable _wake;
+    condition_variable _done;
+    bool _stop;
+    int _generation;
+    int _busy_workers;
+    // current loop
+    Invoker _invoker;
+    void const *_body;
+    int _count;
+    int _chunk_size;
+};
+
+#endif /* THREADPOOL_H */
@@ -0,0 +1,64 @@
+/* 
+ * File:   TimeBasis.cpp
+ * Author: merbar
+ * 
+ * Created on August 6, 2017, 4:12 PM
+ */
+
+#include "TimeBasis.h"
+#include <algorithm>
+
+TimeBasis::TimeBasis() {
+  _horizon = 0;
+}
+
+TimeBasis::~TimeBasis() {
+}
+
+void TimeBasis::set_horizon(int horizon) {
+  if (horizon == _horizon)
+    return;
+  _horizon = horizon;
+  _pos.setZero(horizon, 6);
+  _vel.setZero(horizon, 6);
+  _acc.setZero(horizon, 6);
+  _jerk.setZero(horizon, 6);
+  for (int t = 0; t < horizon; t++) {
+    double tp[6];
+    tp[0] = 1.0;
+    for (int i = 1; i < 6; i++)
+      tp[i] = tp[i-1] * t;
+    for (int i = 0; i < 6; i++) {
+      _pos(t, i) = tp[i];
+      if (i > 0)
+        _vel(t, i) = i * tp[i-1];
+      if (i > 1)
+        _acc(t, i) = i * (i - 1) * tp[i-2];
+      if (i > 2)
+        _jerk(t, i) = i * (i - 1) * (i - 2) * tp[i-3];
+    }
+  }
+}
+
+void TimeBasis::sample(CoefficientMatrix const &coeff_s, CoefficientMatrix const &coeff_d, int count, TrajectorySamples &samples) const {
+  samples.reserve(_horizon, count);
+  samples.s.topLeftCorner(_horizon, count).noalias()      = _pos * coeff_s.leftCols(count);
+  samples.s_vel.topLeftCorner(_horizon, count).noalias()  = _vel * coeff_s.leftCols(count);
+  samples.s_acc.topLeftCorner(_horizon, count).noalias()  = _acc * coeff_s.leftCols(count);
+  samples.s_jerk.topLeftCorner(_horizon, count).noalias() = _jerk * coeff_s.leftCols(count);
+  samples.d.topLeftCorner(_horizon, count).noalias()      = _pos * coeff_d.leftCols(count);
+  samples.d_vel.topLeftCorner(_horizon, count).noalias()  = _vel * coeff_d.leftCols(count);
+  samples.d_acc.topLeftCorner(_horizon, count).noalias()  = _acc * coeff_d.leftCols(count);
+  samples.d_jerk.topLeftCorner(_horizon, count).noalias() = _jerk * coeff_d.leftCols(count);
+}
+
+bool TrajectorySamples::reserve(int horizon, int count) {
+  if ((s.rows() >= horizon) && (s.cols() >= count))
+    return false;
+  int rows = std::max(int(s.rows()), horizon);
+  int cols = std::max(int(s.cols()), count);
+  Eigen::MatrixXd *all[8] = {&s, &s_vel, &s_acc, &s_jerk, &d, &d_vel, &d_acc, &d_jerk};
+  for (Eigen::MatrixXd *m : all)
+    m->resize(rows, cols);
+  return true;
+}
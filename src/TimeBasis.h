@@ -0,0 +1,55 @@
+/* 
+ * File:   TimeBasis.h
+ * Author: merbar
+ *
+ * Created on August 6, 2017, 4:12 PM
+ */
+
+#ifndef TIMEBASIS_H
+#define TIMEBASIS_H
+
+#include "Eigen-3.3/Eigen/Core"
+
+// quintic coefficients of a batch of trajectories. One column per candidate.
+typedef Eigen::Matrix<double, 6, Eigen::Dynamic> CoefficientMatrix;
+
+// sampled positions and derivatives of a batch of trajectories for s and d.
+// One row per timestep, one column per candidate. The matrices may be larger than the batch.
+struct TrajectorySamples {
+    Eigen::MatrixXd s;
+    Eigen::MatrixXd s_vel;
+    Eigen::MatrixXd s_acc;
+    Eigen::MatrixXd s_jerk;
+    Eigen::MatrixXd d;
+    Eigen::MatrixXd d_vel;
+    Eigen::MatrixXd d_acc;
+    Eigen::MatrixXd d_jerk;
+    
+    // makes room for horizon timesteps of count candidates. Returns whether that took a reallocation.
+    bool reserve(int horizon, int count);
+};
+
+// Powers t^0..t^5 for the integer timesteps 0..horizon-1, plus the rows of their
+// first three derivatives. Evaluating all candidates of a cycle then comes down
+// to one matrix product per derivative instead of a pow() per coefficient and timestep.
+class TimeBasis {
+public:
+    typedef Eigen::Matrix<double, Eigen::Dynamic, 6> BasisMatrix;
+
+    TimeBasis();
+    virtual ~TimeBasis();
+    
+    // rebuilds the basis only if the horizon changed
+    void set_horizon(int horizon);
+    // samples the first count columns of the coefficients
+    void sample(CoefficientMatrix const &coeff_s, CoefficientMatrix const &coeff_d, int count, TrajectorySamples &samples) const;
+    
+private:
+    int _horizon;
+    BasisMatrix _pos;
+    BasisMatrix _vel;
+    BasisMatrix _acc;
+    BasisMatrix _jerk;
+};
+
+#endif /* TIMEBASIS_H */
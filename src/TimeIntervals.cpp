@@ -0,0 +1,83 @@
+/* 
+ * File:   TimeIntervals.cpp
+ * Author: merbar
+ * 
+ * Created on August 8, 2017, 9:15 PM
+ */
+
+#include "TimeIntervals.h"
+
+TimeIntervals::TimeIntervals() {
+  _size = 0;
+}
+
+void TimeIntervals::add(double begin, double end) {
+  if ((_size > 0) && (begin <= _end[_size - 1])) {
+    if (end > _end[_size - 1])
+      _end[_size - 1] = end;
+    return;
+  }
+  // can't happen for sets built from quintics. Grow the last interval rather than dropping time.
+  if (_size == capacity) {
+    _end[_size - 1] = end;
+    return;
+  }
+  _begin[_size] = begin;
+  _end[_size] = end;
+  _size++;
+}
+
+int TimeIntervals::size() const {
+  return _size;
+}
+
+bool TimeIntervals::empty() const {
+  return _size == 0;
+}
+
+double TimeIntervals::begin(int i) const {
+  return _begin[i];
+}
+
+double TimeIntervals::end(int i) const {
+  return _end[i];
+}
+
+double TimeIntervals::first_begin(double fallback) const {
+  if (_size == 0)
+    return fallback;
+  return _begin[0];
+}
+
+TimeIntervals TimeIntervals::intersect(TimeIntervals const &other) const {
+  TimeIntervals result;
+  int i = 0;
+  int j = 0;
+  while ((i < _size) && (j < other._size)) {
+    double begin = max(_begin[i], other._begin[j]);
+    double end = min(_end[i], other._end[j]);
+    if (end > begin)
+      result.add(begin, end);
+    if (_end[i] < other._end[j])
+      i++;
+    else
+      j++;
+  }
+  return result;
+}
+
+TimeIntervals TimeIntervals::unite(TimeIntervals const &other) const {
+  TimeIntervals result;
+  int i = 0;
+  int j = 0;
+  while ((i < _size) || (j < other._size)) {
+    if ((j == other._size) || ((i < _size) && (_begin[i] <= other._begin[j]))) {
+      result.add(_begin[i], _end[i]);
+      i++;
+    } else {
+      result.add(other._begin[j], other._end[j]);
+      j++;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,69 @@
+/* 
+ * File:   TimeIntervals.h
+ * Author: merbar
+ *
+ * Created on August 8, 2017, 9:15 PM
+ */
+
+#ifndef TIMEINTERVALS_H
+#define TIMEINTERVALS_H
+
+#include "Polynomial.h"
+
+// Sorted, disjoint time intervals [begin, end].
+// Fixed capacity, so sets can be built and combined without touching the heap.
+// Sets come from polynomial sign conditions, which only ever produce a handful of intervals.
+class TimeIntervals {
+public:
+    static const int capacity = 16;
+    
+    TimeIntervals();
+    
+    // appends an interval past the current end, merging it with the last one if they touch
+    void add(double begin, double end);
+    int size() const;
+    bool empty() const;
+    double begin(int i) const;
+    double end(int i) const;
+    // start of the first interval, or fallback if there is none
+    double first_begin(double fallback) const;
+    
+    TimeIntervals intersect(TimeIntervals const &other) const;
+    TimeIntervals unite(TimeIntervals const &other) const;
+    
+    // {t in [t_begin, t_end] : p(t) < limit}
+    template <int Degree>
+    static TimeIntervals below(Polynomial<Degree> const &p, double limit, double t_begin, double t_end) {
+        return where_sign(p, limit, t_begin, t_end, -1.0);
+    }
+    
+    // {t in [t_begin, t_end] : p(t) > limit}
+    template <int Degree>
+    static TimeIntervals above(Polynomial<Degree> const &p, double limit, double t_begin, double t_end) {
+        return where_sign(p, limit, t_begin, t_end, 1.0);
+    }
+    
+private:
+    // the roots of p - limit split [t_begin, t_end] into pieces on which the sign is constant
+    template <int Degree>
+    static TimeIntervals where_sign(Polynomial<Degree> const &p, double limit, double t_begin, double t_end, double sign) {
+        Polynomial<Degree> p_limit = p - limit;
+        double roots[Degree > 0 ? Degree : 1];
+        int num_roots = p_limit.real_roots(t_begin, t_end, roots);
+        TimeIntervals result;
+        double a = t_begin;
+        for (int i = 0; i <= num_roots; i++) {
+            double b = (i < num_roots) ? roots[i] : t_end;
+            if ((b > a) && (sign * p_limit.eval(0.5 * (a + b)) > 0.0))
+                result.add(a, b);
+            a = b;
+        }
+        return result;
+    }
+    
+    int _size;
+    double _begin[capacity];
+    double _end[capacity];
+};
+
+#endif /* TIMEINTERVALS_H */
@@ -0,0 +1,130 @@
+/*
+ * File:   Track.cpp
+ * Author: merbar
+ *
+ * Created on August 21, 2017, 6:30 PM
+ */
+
+#include "Track.h"
+#include <math.h>
+
+// points converted per pass of the batched xy(), sized to keep the scratch arrays on the stack
+static const int xy_chunk = 64;
+
+Track::Track() : _closed(false), _length(0) {
+}
+
+Track::~Track() {
+}
+
+void Track::build(Map const &map) {
+  vector<double> const &map_s = map.s();
+  int n = map.size();
+  // closed if the way back to the first waypoint isn't any longer than the ones between waypoints
+  double longest_gap = 0;
+  for (int i = 1; i < n; i++)
+    longest_gap = max(longest_gap, map.arc_length(i) - map.arc_length(i - 1));
+  double closing_gap = sqrt(pow(map.x()[0] - map.x()[n - 1], 2) + pow(map.y()[0] - map.y()[n - 1], 2));
+  _closed = (closing_gap <= longest_gap);
+  _length = _closed ? map_s[n - 1] + closing_gap : map_s[n - 1];
+
+  vector<MultiSpline<4>::Values> centerline(n);
+  for (int i = 0; i < n; i++)
+    centerline[i] = {{map.x()[i], map.y()[i], map.dx()[i], map.dy()[i]}};
+  _centerline.fit(map_s, centerline, _closed ? _length : 0.0);
+}
+
+bool Track::closed() const {
+  return _closed;
+}
+
+double Track::length() const {
+  return _length;
+}
+
+double Track::wrap(double s) const {
+  if (!_closed)
+    return s;
+  s = fmod(s, _length);
+  return (s < 0) ? s + _length : s;
+}
+
+double Track::unwrap(double s, double reference) const {
+  if (!_closed)
+    return s;
+  return s - _length * round((s - reference) / _length);
+}
+
+double Track::x(double s) const {
+  double centerline[4];
+  _centerline.eval(s, centerline);
+  return centerline[0];
+}
+
+double Track::y(double s) const {
+  double centerline[4];
+  _centerline.eval(s, centerline);
+  return centerline[1];
+}
+
+double Track::dx(double s) const {
+  double centerline[4];
+  _centerline.eval(s, centerline);
+  return centerline[2];
+}
+
+double Track::dy(double s) const {
+  double centerline[4];
+  _centerline.eval(s, centerline);
+  return centerline[3];
+}
+
+void Track::xy(double s, double d, double &x, double &y) const {
+  double centerline[4];
+  _centerline.eval(s, centerline);
+  x = centerline[0] + centerline[2] * d;
+  y = centerline[1] + centerline[3] * d;
+}
+
+void Track::xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y) const {
+  int cursor = -1;
+  xy(s, d, x, y, cursor);
+}
+
+void Track::xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y, int &cursor) const {
+  int n = s.size();
+  int interval = cursor;
+  x.resize(n);
+  y.resize(n);
+  double centerline[xy_chunk * 4];
+  for (int begin = 0; begin < n; begin += xy_chunk) {
+    int count = min(xy_chunk, n - begin);
+    _centerline.eval(&s[begin], count, centerline, interval);
+    if (begin == 0)
+      cursor = interval;
+    for (int i = 0; i < count; i++) {
+      x[begin + i] = centerline[i * 4] + centerline[i * 4 + 2] * d[begin + i];
+      y[begin + i] = centerline[i * 4 + 1] + centerline[i * 4 + 3] * d[begin + i];
+    }
+  }
+}
+
+void Track::centerline(double s, double *values, double *derivatives) const {
+  _centerline.eval(s, values);
+  _centerline.deriv(1, s, derivatives);
+}
+
+double Track::curvature(double s) const {
+  double first[4];
+  double second[4];
+  _centerline.deriv(1, s, first);
+  _centerline.deriv(2, s, second);
+  return (first[0] * second[1] - first[1] * second[0]) / pow(first[0] * first[0] + first[1] * first[1], 1.5);
+}
+
+double Track::offset_ratio(double s, double d) const {
+  double first[4];
+  _centerline.deriv(1, s, first);
+  // x/y of the offset line change with the centerline and with the normal it is offset along
+  return sqrt(pow(first[0] + first[2] * d, 2) + pow(first[1] + first[3] * d, 2)) / sqrt(first[0] * first[0] + first[1] * first[1]);
+}
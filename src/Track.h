@@ -0,0 +1,65 @@
+/*
+ * File:   Track.h
+ * Author: merbar
+ *
+ * Created on August 21, 2017, 6:30 PM
+ */
+
+#ifndef TRACK_H
+#define TRACK_H
+
+#include "Map.h"
+#include "MultiSpline.h"
+
+using namespace std;
+
+// Smooth centerline of the whole track: splines from s to x, y and the normal dx, dy,
+// fitted together once over all waypoints at startup.
+// A closed track (the last waypoint leads back to the first one) is periodic in s with period length().
+// An open track is fitted with natural boundaries and s is used as is.
+class Track {
+public:
+    Track();
+    virtual ~Track();
+
+    void build(Map const &map);
+
+    bool closed() const;
+    // s at which a closed track starts over, the s of the last waypoint on an open one
+    double length() const;
+
+    // s on a closed track taken into [0, length)
+    double wrap(double s) const;
+    // s moved by whole laps to within half a lap of reference, so s of things around the car is continuous
+    double unwrap(double s, double reference) const;
+
+    double x(double s) const;
+    double y(double s) const;
+    double dx(double s) const;
+    double dy(double s) const;
+    // Frenet s,d to Cartesian x,y. Projects out along the spline normal, which is much smoother than
+    // the heading of the segment between two waypoints.
+    void xy(double s, double d, double &x, double &y) const;
+    // the same for a whole path. Fastest with s in increasing order, like the s of a planned trajectory.
+    void xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y) const;
+    // with a cursor the caller keeps from one path to the next: the spline interval the last path started in.
+    // The car moves on by at most a waypoint or two between paths, so the new start is found right
+    // there instead of searching all waypoints. Start with -1.
+    void xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y, int &cursor) const;
+
+    // x, y, dx, dy at s and their derivatives along s
+    void centerline(double s, double *values, double *derivatives) const;
+    // signed curvature of the centerline, positive in left turns
+    double curvature(double s) const;
+    // distance along a line at offset d per distance along the centerline. Above 1 on the outside of a turn.
+    double offset_ratio(double s, double d) const;
+
+private:
+    bool _closed;
+    double _length;
+    // x, y, dx, dy
+    MultiSpline<4> _centerline;
+};
+
+#endif /* TRACK_H */
+
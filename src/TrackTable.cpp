@@ -0,0 +1,103 @@
+/*
+ * File:   TrackTable.cpp
+ * Author: merbar
+ *
+ * Created on August 24, 2017, 6:20 PM
+ */
+
+#include "TrackTable.h"
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+
+// points between two samples the error is measured at
+static const int error_checks = 8;
+
+TrackTable::TrackTable() : _track(NULL), _length(0), _closed(false), _step(0.5), _inv_step(2.0), _max_error(0) {
+}
+
+TrackTable::~TrackTable() {
+}
+
+void TrackTable::build(Track const &track, double step, double max_d) {
+  assert(step > 0);
+  _track = &track;
+  _length = track.length();
+  _closed = track.closed();
+  _step = step;
+  _inv_step = 1.0 / step;
+  // the last interval ends at or past the end of the track
+  int num_intervals = int(ceil(track.length() / step));
+  _intervals.resize(num_intervals);
+  double value[4], next_value[4];
+  double slope[4], next_slope[4];
+  track.centerline(0.0, next_value, next_slope);
+  for (int i = 0; i < num_intervals; i++) {
+    copy(next_value, next_value + 4, value);
+    copy(next_slope, next_slope + 4, slope);
+    track.centerline((i + 1) * step, next_value, next_slope);
+    Interval &interval = _intervals[i];
+    for (int k = 0; k < 4; k++) {
+      double m0 = slope[k] * step;
+      double m1 = next_slope[k] * step;
+      interval.c0[k] = value[k];
+      interval.c1[k] = m0;
+      interval.c2[k] = 3 * (next_value[k] - value[k]) - 2 * m0 - m1;
+      interval.c3[k] = 2 * (value[k] - next_value[k]) + m0 + m1;
+    }
+  }
+
+  // the deviation grows linearly with d, so the centerline and max_d bound it
+  double const offsets[] = {0.0, max_d};
+  _max_error = 0;
+  for (int i = 0; i < num_intervals; i++) {
+    for (int j = 1; j < error_checks; j++) {
+      double s = (i + double(j) / error_checks) * step;
+      for (double d : offsets) {
+        double x, y, spline_x, spline_y;
+        xy(s, d, x, y);
+        track.xy(s, d, spline_x, spline_y);
+        _max_error = max(_max_error, sqrt(pow(x - spline_x, 2) + pow(y - spline_y, 2)));
+      }
+    }
+  }
+}
+
+double TrackTable::step() const {
+  return _step;
+}
+
+double TrackTable::max_error() const {
+  return _max_error;
+}
+
+void TrackTable::xy(double s, double d, double &x, double &y) const {
+  eval(s, d, x, y);
+}
+
+void TrackTable::xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y) const {
+  int n = s.size();
+  x.resize(n);
+  y.resize(n);
+  for (int i = 0; i < n; i++)
+    eval(s[i], d[i], x[i], y[i]);
+}
+
+void TrackTable::eval(double s, double d, double &x, double &y) const {
+  // most s are on the first lap already
+  if (_closed && ((s < 0) || (s >= _length)))
+    s = _track->wrap(s);
+  double position = s * _inv_step;
+  if ((position < 0) || (position >= _intervals.size())) {
+    _track->xy(s, d, x, y);
+    return;
+  }
+  int i = int(position);
+  double t = position - i;
+  Interval const &interval = _intervals[i];
+  double centerline[4];
+  for (int k = 0; k < 4; k++)
+    centerline[k] = ((interval.c3[k] * t + interval.c2[k]) * t + interval.c1[k]) * t + interval.c0[k];
+  x = centerline[0] + centerline[2] * d;
+  y = centerline[1] + centerline[3] * d;
+}
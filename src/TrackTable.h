@@ -0,0 +1,58 @@
+/*
+ * File:   TrackTable.h
+ * Author: merbar
+ *
+ * Created on August 24, 2017, 6:20 PM
+ */
+
+#ifndef TRACKTABLE_H
+#define TRACKTABLE_H
+
+#include <vector>
+#include "Track.h"
+
+using namespace std;
+
+// The track centerline resampled at a fixed s step, as an alternative to evaluating its splines.
+// x, y, dx, dy and their slopes along s are sampled at every step, and every interval between two
+// samples keeps the cubic Hermite interpolation of them in power form. Converting a point is index
+// arithmetic and one Horner evaluation, without any search.
+// The largest deviation from the splines is measured when the table is built.
+class TrackTable {
+public:
+    TrackTable();
+    virtual ~TrackTable();
+
+    // max_d is the largest offset from the centerline the error is measured for, e.g. the road width
+    void build(Track const &track, double step = 0.5, double max_d = 12.0);
+
+    double step() const;
+    // largest distance to the spline position found between samples, for offsets from 0 to max_d
+    double max_error() const;
+
+    // Frenet s,d to Cartesian x,y. Off the ends of an open track, the track's splines are used.
+    void xy(double s, double d, double &x, double &y) const;
+    void xy(vector<double> const &s, vector<double> const &d, vector<double> &x, vector<double> &y) const;
+
+private:
+    // x, y, dx, dy as c0 + c1 t + c2 t^2 + c3 t^3 with t from 0 to 1 across the interval
+    struct Interval {
+        double c0[4];
+        double c1[4];
+        double c2[4];
+        double c3[4];
+    };
+
+    void eval(double s, double d, double &x, double &y) const;
+
+    Track const *_track;
+    double _length;
+    bool _closed;
+    double _step;
+    double _inv_step;
+    double _max_error;
+    vector<Interval> _intervals;
+};
+
+#endif /* TRACKTABLE_H */
+
@@ -0,0 +1,90 @@
+/*
+ * File:   TrafficPrediction.cpp
+ * Author: merbar
+ *
+ * Created on August 18, 2017, 8:05 PM
+ */
+
+#include "TrafficPrediction.h"
+#include <algorithm>
+
+TrafficPrediction::TrafficPrediction() {
+  _horizon = 0;
+  _num_vehicles = 0;
+}
+
+TrafficPrediction::~TrafficPrediction() {
+}
+
+bool TrafficPrediction::reserve(int horizon, int num_vehicles) {
+  int size = horizon * num_vehicles;
+  if ((_s.capacity() >= size_t(size)) && (_lane_begin.capacity() >= size_t(horizon * (num_lanes + 1))))
+    return false;
+  _s.reserve(size);
+  _d.reserve(size);
+  _occupied.reserve(size);
+  _lane_begin.reserve(horizon * (num_lanes + 1));
+  return true;
+}
+
+void TrafficPrediction::predict(TrafficSnapshot const &traffic, int horizon, double vehicle_length) {
+  _horizon = horizon;
+  _num_vehicles = traffic.size();
+  _s.resize(_horizon * _num_vehicles);
+  _d.resize(_horizon * _num_vehicles);
+  _occupied.resize(_horizon * _num_vehicles);
+  _lane_begin.resize(_horizon * (num_lanes + 1));
+  double half_length = 0.5 * vehicle_length;
+  for (int t = 0; t < _horizon; t++) {
+    double *s = _s.data() + t * _num_vehicles;
+    double *d = _d.data() + t * _num_vehicles;
+    int *lane_begin = _lane_begin.data() + t * (num_lanes + 1);
+    OccupiedInterval *occupied = _occupied.data() + t * _num_vehicles;
+    for (int i = 0; i <= num_lanes; i++)
+      lane_begin[i] = 0;
+    for (int i = 0; i < _num_vehicles; i++) {
+      s[i] = traffic.s_at(i, t);
+      d[i] = traffic.d(i);
+      lane_begin[lane_of(d[i]) + 1]++;
+    }
+    for (int i = 0; i < num_lanes; i++)
+      lane_begin[i + 1] += lane_begin[i];
+    int next[num_lanes];
+    std::copy(lane_begin, lane_begin + num_lanes, next);
+    for (int i = 0; i < _num_vehicles; i++) {
+      OccupiedInterval &interval = occupied[next[lane_of(d[i])]++];
+      interval.s_min = s[i] - half_length;
+      interval.s_max = s[i] + half_length;
+      interval.vehicle = i;
+    }
+    // lanes only hold a few vehicles
+    for (int l = 0; l < num_lanes; l++) {
+      for (int i = lane_begin[l] + 1; i < lane_begin[l + 1]; i++) {
+        OccupiedInterval interval = occupied[i];
+        int j = i;
+        for (; (j > lane_begin[l]) && (occupied[j - 1].s_min > interval.s_min); j--)
+          occupied[j] = occupied[j - 1];
+        occupied[j] = interval;
+      }
+    }
+  }
+}
+
+int TrafficPrediction::horizon() const {
+  return _horizon;
+}
+
+int TrafficPrediction::num_vehicles() const {
+  return _num_vehicles;
+}
+
+void TrafficPrediction::overlapping(int t, int lane, double s_min, double s_max, OccupiedInterval const *&begin, OccupiedInterval const *&end) const {
+  int const *lane_begin = _lane_begin.data() + t * (num_lanes + 1);
+  OccupiedInterval const *occupied = _occupied.data() + t * _num_vehicles;
+  // all intervals have the same length, so sorting by s_min sorts by s_max as well
+  begin = std::lower_bound(occupied + lane_begin[lane], occupied + lane_begin[lane + 1], s_min,
+                           [](OccupiedInterval const &interval, double s) { return interval.s_max < s; });
+  end = begin;
+  while ((end != occupied + lane_begin[lane + 1]) && (end->s_min <= s_max))
+    end++;
+}
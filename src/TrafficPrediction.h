@@ -0,0 +1,64 @@
+/*
+ * File:   TrafficPrediction.h
+ * Author: merbar
+ *
+ * Created on August 18, 2017, 8:05 PM
+ */
+
+#ifndef TRAFFICPREDICTION_H
+#define TRAFFICPREDICTION_H
+
+#include <vector>
+#include "TrafficSnapshot.h"
+
+using namespace std;
+
+// s range a vehicle's body covers in its lane at one timestep
+struct OccupiedInterval {
+    double s_min;
+    double s_max;
+    int vehicle;
+};
+
+// Predicted s/d of all vehicles at every timestep of the horizon, computed once per cycle.
+// Values are stored time-major, so the vehicles of one timestep are next to each other.
+// Every timestep also lists the s intervals occupied in each lane, sorted by s, so checks
+// around the ego position only look at vehicles that are actually nearby.
+class TrafficPrediction {
+public:
+    static const int num_lanes = 3;
+
+    TrafficPrediction();
+    virtual ~TrafficPrediction();
+
+    // makes room for a horizon and vehicle count. Returns whether that took a reallocation.
+    bool reserve(int horizon, int num_vehicles);
+    void predict(TrafficSnapshot const &traffic, int horizon, double vehicle_length);
+
+    int horizon() const;
+    int num_vehicles() const;
+
+    double s(int t, int vehicle) const {
+        return _s[t * _num_vehicles + vehicle];
+    }
+
+    double d(int t, int vehicle) const {
+        return _d[t * _num_vehicles + vehicle];
+    }
+
+    // intervals of a lane at timestep t that overlap [s_min, s_max], as [begin, end)
+    void overlapping(int t, int lane, double s_min, double s_max, OccupiedInterval const *&begin, OccupiedInterval const *&end) const;
+
+private:
+    int _horizon;
+    int _num_vehicles;
+    vector<double> _s;
+    vector<double> _d;
+    // per timestep, the intervals of lane 0, then lane 1, then lane 2
+    vector<OccupiedInterval> _occupied;
+    // per timestep, num_lanes + 1 offsets into its intervals
+    vector<int> _lane_begin;
+};
+
+#endif /* TRAFFICPREDICTION_H */
+
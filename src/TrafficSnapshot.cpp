@@ -0,0 +1,128 @@
+/*
+ * File:   TrafficSnapshot.cpp
+ * Author: merbar
+ *
+ * Created on August 19, 2017, 7:40 PM
+ */
+
+#include "TrafficSnapshot.h"
+#include <algorithm>
+
+TrafficSnapshot::TrafficSnapshot() {
+  for (int i = 0; i <= num_lanes; i++)
+    _lane_begin[i] = 0;
+}
+
+TrafficSnapshot::~TrafficSnapshot() {
+}
+
+bool TrafficSnapshot::reserve(int num_vehicles) {
+  if (_source.capacity() >= size_t(num_vehicles))
+    return false;
+  _source.reserve(num_vehicles);
+  _s.reserve(num_vehicles);
+  _d.reserve(num_vehicles);
+  _s_vel.reserve(num_vehicles);
+  _lane.reserve(num_vehicles);
+  _by_lane.reserve(num_vehicles);
+  return true;
+}
+
+void TrafficSnapshot::build(vector<Vehicle> const &vehicles, double ego_s, double look_ahead, double max_travel, double reach, int horizon) {
+  _source.clear();
+  _s.clear();
+  _d.clear();
+  _s_vel.clear();
+  _lane.clear();
+  for (int i = 0; i <= num_lanes; i++)
+    _lane_begin[i] = 0;
+  // closest vehicle of every lane that is ahead but out of reach. It's the leader of everything in reach.
+  int beyond[num_lanes] = {-1, -1, -1};
+  for (int i = 0; i < (int)vehicles.size(); i++) {
+    double s_start = vehicles[i].s_at(0);
+    if (near(vehicles[i], ego_s, max_travel, reach, horizon) || (s_start <= ego_s) || (s_start - ego_s >= look_ahead))
+      continue;
+    int &closest = beyond[lane_of(vehicles[i].d_at(0))];
+    if ((closest == -1) || (s_start < vehicles[closest].s_at(0)))
+      closest = i;
+  }
+  for (int i = 0; i < (int)vehicles.size(); i++) {
+    int lane = lane_of(vehicles[i].d_at(0));
+    if ((i != beyond[lane]) && !near(vehicles[i], ego_s, max_travel, reach, horizon))
+      continue;
+    _source.push_back(i);
+    _s.push_back(vehicles[i].s_at(0));
+    _d.push_back(vehicles[i].d_at(0));
+    _s_vel.push_back(vehicles[i].s_vel());
+    _lane.push_back(lane);
+    _lane_begin[lane + 1]++;
+  }
+  for (int i = 0; i < num_lanes; i++)
+    _lane_begin[i + 1] += _lane_begin[i];
+  _by_lane.resize(_source.size());
+  int next[num_lanes];
+  std::copy(_lane_begin, _lane_begin + num_lanes, next);
+  for (int i = 0; i < size(); i++)
+    _by_lane[next[_lane[i]]++] = i;
+  // ties keep the lower index first, like a linear scan would
+  for (int l = 0; l < num_lanes; l++) {
+    std::sort(_by_lane.begin() + _lane_begin[l], _by_lane.begin() + _lane_begin[l + 1], [this](int a, int b) {
+      return (_s[a] < _s[b]) || ((_s[a] == _s[b]) && (a < b));
+    });
+  }
+}
+
+bool TrafficSnapshot::near(Vehicle const &vehicle, double ego_s, double max_travel, double reach, int horizon) {
+  double s_start = vehicle.s_at(0);
+  double s_end = vehicle.s_at(horizon - 1);
+  return (min(s_start, s_end) - reach <= ego_s + max_travel) && (max(s_start, s_end) + reach >= ego_s);
+}
+
+int TrafficSnapshot::size() const {
+  return _source.size();
+}
+
+int TrafficSnapshot::source(int i) const {
+  return _source[i];
+}
+
+double TrafficSnapshot::s(int i) const {
+  return _s[i];
+}
+
+double TrafficSnapshot::d(int i) const {
+  return _d[i];
+}
+
+double TrafficSnapshot::s_vel(int i) const {
+  return _s_vel[i];
+}
+
+int TrafficSnapshot::lane(int i) const {
+  return _lane[i];
+}
+
+double TrafficSnapshot::s_at(int i, double t) const {
+  return _s[i] + t * _s_vel[i];
+}
+
+Polynomial<1> TrafficSnapshot::s_trajectory(int i) const {
+  Polynomial<1> s;
+  s[0] = _s[i];
+  s[1] = _s_vel[i];
+  return s;
+}
+
+int TrafficSnapshot::leader(int lane, double s) const {
+  vector<int>::const_iterator begin = _by_lane.begin() + _lane_begin[lane];
+  vector<int>::const_iterator end = _by_lane.begin() + _lane_begin[lane + 1];
+  vector<int>::const_iterator it = std::upper_bound(begin, end, s, [this](double s, int i) { return s < _s[i]; });
+  return (it == end) ? -1 : *it;
+}
+
+int TrafficSnapshot::follower(int lane, double s) const {
+  vector<int>::const_iterator begin = _by_lane.begin() + _lane_begin[lane];
+  vector<int>::const_iterator end = _by_lane.begin() + _lane_begin[lane + 1];
+  vector<int>::const_iterator it = std::lower_bound(begin, end, s, [this](int i, double s) { return _s[i] < s; });
+  return (it == begin) ? -1 : *(it - 1);
+}
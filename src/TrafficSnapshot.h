@@ -0,0 +1,65 @@
+/*
+ * File:   TrafficSnapshot.h
+ * Author: merbar
+ *
+ * Created on August 19, 2017, 7:40 PM
+ */
+
+#ifndef TRAFFICSNAPSHOT_H
+#define TRAFFICSNAPSHOT_H
+
+#include <vector>
+#include "Vehicle.h"
+#include "Polynomial.h"
+
+using namespace std;
+
+// The vehicles that matter to one planning cycle, built once per telemetry frame.
+// Only vehicles that can get near the ego vehicle within the horizon are kept, plus the closest
+// vehicle ahead of those in every lane. The rest can't change the plan and are dropped up front.
+// Vehicles are stored as plain arrays, and every lane keeps its vehicles sorted by s, so leader
+// and follower lookups are binary searches.
+class TrafficSnapshot {
+public:
+    static const int num_lanes = 3;
+
+    TrafficSnapshot();
+    virtual ~TrafficSnapshot();
+
+    // makes room for num_vehicles. Returns whether that took a reallocation.
+    bool reserve(int num_vehicles);
+    // keeps the vehicles that come within reach of [ego_s, ego_s + max_travel] at some time of the horizon,
+    // and in every lane the closest one ahead of those, if it is less than look_ahead ahead of ego_s
+    void build(vector<Vehicle> const &vehicles, double ego_s, double look_ahead, double max_travel, double reach, int horizon);
+
+    int size() const;
+    // index of a snapshot vehicle in the vector it was built from
+    int source(int i) const;
+    double s(int i) const;
+    double d(int i) const;
+    double s_vel(int i) const;
+    int lane(int i) const;
+    // same constant velocity prediction as Vehicle
+    double s_at(int i, double t) const;
+    Polynomial<1> s_trajectory(int i) const;
+
+    // closest vehicle in a lane with s above / below the given s, -1 if there is none.
+    // Leaders are exact for any s up to the end of the reach, followers only see vehicles in reach.
+    int leader(int lane, double s) const;
+    int follower(int lane, double s) const;
+
+private:
+    static bool near(Vehicle const &vehicle, double ego_s, double max_travel, double reach, int horizon);
+
+    vector<int> _source;
+    vector<double> _s;
+    vector<double> _d;
+    vector<double> _s_vel;
+    vector<int> _lane;
+    // snapshot indices of every lane, sorted by s. Lane l is [_lane_begin[l], _lane_begin[l + 1]).
+    vector<int> _by_lane;
+    int _lane_begin[num_lanes + 1];
+};
+
+#endif /* TRAFFICSNAPSHOT_H */
+
@@ -53,6 +53,17 @@ vector<double> Vehicle::get_d() const {
 // - vehicle stays in lane
 // - vehicle has constant speed
 vector<double> Vehicle::state_at(double t) const {
-  double new_s = _pos_s + t * _vel_s;
-  return {new_s, _pos_d};
+  return {s_at(t), d_at(t)};
+}
+
+double Vehicle::s_at(double t) const {
+  return _pos_s + t * _vel_s;
+}
+
+double Vehicle::d_at(double t) const {
+  return _pos_d;
+}
+
+double Vehicle::s_vel() const {
+  return _vel_s;
 }
\ No newline at end of file
@@ -20,6 +20,15 @@
 
 using namespace std;
 
+// 0: left, 1: middle, 2: right. Positions off the road count to the closest lane.
+inline int lane_of(double d) {
+    if (d > 8)
+        return 2;
+    if (d > 4)
+        return 1;
+    return 0;
+}
+
 class Vehicle {
 public:
     Vehicle();
@@ -30,6 +39,10 @@ public:
     vector<double> get_s() const;
     vector<double> get_d() const;
     vector<double> state_at(double t) const;
+    // non-allocating variants of state_at() for per-timestep loops
+    double s_at(double t) const;
+    double d_at(double t) const;
+    double s_vel() const;
     // part of hack to fight lag. Range of states from previous path 10 steps out from update_interval
     // contains {s_vel, s_acc, d_vel, d_acc}
     vector<vector<double>> _future_states = {{0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0},{0,0,0,0},
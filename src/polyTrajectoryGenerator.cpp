@@ -6,201 +6,303 @@
  */
 
 #include "polyTrajectoryGenerator.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include "AllocationCounter.h"
 
-PolyTrajectoryGenerator::PolyTrajectoryGenerator() {
+PolyTrajectoryGenerator::PolyTrajectoryGenerator(unsigned int seed) : _sampler(seed) {
 }
 
 PolyTrajectoryGenerator::~PolyTrajectoryGenerator() {
 }
 
-double PolyTrajectoryGenerator::exceeds_speed_limit_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  for (int i = 0; i < _horizon; i++) {
-    if (traj.first.eval_d(i) + traj.second.eval_d(i) > _hard_max_vel_per_timestep)
-      return 1.0;
-  }
-  return 0.0;
+// penalizes low average speeds compared to speed limit
+double PolyTrajectoryGenerator::efficiency_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, Goal const &goal, vector<Vehicle> const &vehicles) {
+  double s_dist = goal[0] - traj.first.eval(0);
+  double max_dist = _delta_s_maxspeed;
+  return abs(logistic((max_dist - s_dist) / max_dist)); // abs() because going faster is actually bad
 }
 
-double PolyTrajectoryGenerator::exceeds_accel_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  for (int i = 0; i < _horizon; i++) {
-    if (traj.first.eval_double_d(i) + traj.second.eval_double_d(i) > _hard_max_acc_per_timestep)
-      return 1.0;
+// nudges vehicle to proactively depart lanes with traffic ahead and prevent changing into busy lanes
+double PolyTrajectoryGenerator::traffic_ahead_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, Goal const &goal, vector<Vehicle> const &vehicles) {
+  double ego_s = traj.first.eval(0);
+  double ego_d = traj.second.eval(0);
+  double ego_d_end = traj.second.eval(_horizon);
+  int look_ahead = 400;
+  
+  int fut_lane_i = lane_of(ego_d_end);
+  int closest_veh_fut_i = closest_vehicle_in_lane(ego_s, fut_lane_i, vehicles);
+  // if there is a vehicle in the lane the trajectory will take us to
+  if (closest_veh_fut_i != -1) {
+    float dif_s = vehicles[closest_veh_fut_i].s_at(0) - ego_s;
+    if (dif_s < look_ahead) {
+      // don't switch into a lane with slower traffic ahead
+      int cur_lane_i = lane_of(ego_d);
+      int closest_veh_i = closest_vehicle_in_lane(ego_s, cur_lane_i, vehicles);
+      // if there is a vehicle in the current lane AND make range a bit tighter
+      if ((closest_veh_i != -1) && (dif_s < look_ahead / 2.0)) {
+        double ego_s_vel = traj.first.eval_d(0);
+        // traffic in planned lane clearly slower than in current?
+        if (vehicles[closest_veh_fut_i].s_vel() < vehicles[closest_veh_i].s_vel() * 0.95)
+          return 1000;
+      }
+      // end - don't switch into a lane with slower traffic ahead
+      
+      // no slower traffic in goal lane, so return regular cost
+      return logistic(1 - (dif_s / look_ahead));
+    }
   }
   return 0.0;
 }
 
-double PolyTrajectoryGenerator::exceeds_jerk_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  for (int i = 0; i < _horizon; i++) {
-    if (traj.first.eval_triple_d(i) + traj.second.eval_triple_d(i) > _hard_max_jerk_per_timestep)
-      return 1.0;
+
+// true if p exceeds limit at any integer timestep of the horizon.
+// The roots of p - limit split the horizon into pieces that are either entirely above or below the limit,
+// so only pieces above it that contain a timestep need to be found.
+template <int Degree>
+bool PolyTrajectoryGenerator::exceeds_on_horizon(Polynomial<Degree> const &p, double limit) const {
+  Polynomial<Degree> p_limit = p - limit;
+  double t_end = _horizon - 1;
+  double roots[Degree > 0 ? Degree : 1];
+  int num_roots = p_limit.real_roots(0.0, t_end, roots);
+  double a = 0.0;
+  for (int i = 0; i <= num_roots; i++) {
+    double b = (i < num_roots) ? roots[i] : t_end;
+    if ((p_limit.eval(0.5 * (a + b)) > 0.0) && (ceil(a) <= floor(b)))
+      return true;
+    a = b;
   }
-  return 0.0;
+  return false;
 }
 
-double PolyTrajectoryGenerator::collision_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  for (int i = 0; i < vehicles.size(); i++) {
-    for (int t = 0; t < _horizon; t++) {
-      double ego_s = traj.first.eval(t);
-      double ego_d = traj.second.eval(t);
-      vector<double> traffic_state = vehicles[i].state_at(t); // {s,d}
-      
-      double dif_s = traffic_state[0] - ego_s;
-      double dif_d = abs(traffic_state[1] - ego_d);
-      // Ignore (potentially faster) vehicles from behind or that have fallen behind
-      // Tried it and ego moved out of their way, often hitting slower traffic. Not fun.
-      if (((dif_s < -5) && (dif_d < 2.0)) || (((dif_s < -15) && (dif_d > 2.0))))
-        break;
-      
-      dif_s = abs(dif_s);
-      
-      
-      // make the envelope a little wider to stay "out of trouble"
-      if ((dif_s <= _car_col_length * 5.0) && (dif_d <= _car_col_width * 3.0))
-        return 1.0;
-    }
-  }
-  return 0.0;
+// speed, acceleration and jerk limits decided in constant time from the coefficients.
+// Always passes in CHECK_SAMPLED mode, evaluate_trajectory() then checks every timestep.
+bool PolyTrajectoryGenerator::within_dynamic_limits(pair<QuinticPolynomial, QuinticPolynomial> const &traj) {
+  if (_limit_check_mode == CHECK_SAMPLED)
+    return true;
+  // limits apply to the sum of s and d derivatives
+  Polynomial<4> vel = (traj.first + traj.second).derivative();
+  Polynomial<3> acc = vel.derivative();
+  Polynomial<2> jerk = acc.derivative();
+  return !exceeds_on_horizon(vel, _hard_max_vel_per_timestep) &&
+         !exceeds_on_horizon(acc, _hard_max_acc_per_timestep) &&
+         !exceeds_on_horizon(jerk, _hard_max_jerk_per_timestep);
 }
 
-// adds cost for getting too close to another vehicle
-double PolyTrajectoryGenerator::traffic_buffer_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double cost = 0.0;
-  for (int i = 0; i < vehicles.size(); i++) {
-    for (int t = 0; t < _horizon; t++) {
-      double ego_s = traj.first.eval(t);
-      double ego_d = traj.second.eval(t);
-      vector<double> traffic_state = vehicles[i].state_at(t); // {s,d}
-      
-      double dif_s = traffic_state[0] - ego_s;
-      // Ignore (potentially faster) vehicles from behind or that have fallen behind
-      // Tried it and ego moved out of their way, often hitting slower traffic. Not fun.
-      if (dif_s < -10)
-        break;
-      dif_s = abs(dif_s);
-      double dif_d = abs(traffic_state[1] - ego_d);
-      
-      // if in the same lane and too close
-      if ((dif_s <= _col_buf_length) && (dif_d <= _col_buf_width))
-        cost += logistic(1 - (dif_s / _col_buf_length)) / _horizon;
-    }
+// broad phase: each vehicle's predicted s/d extent over the horizon, grown by the largest envelope
+// of the collision and traffic buffer checks. Computed once per cycle.
+void PolyTrajectoryGenerator::update_traffic_bounds() {
+  const double reach_s = max(_car_col_length * 5.0, _col_buf_length);
+  const double reach_d = max(_car_col_width * 3.0, _col_buf_width);
+  _traffic_bounds.resize(_snapshot.size());
+  for (int i = 0; i < _snapshot.size(); i++) {
+    double s_start = _snapshot.s_at(i, 0);
+    double s_end = _snapshot.s_at(i, _horizon - 1);
+    _traffic_bounds[i].s_min = min(s_start, s_end) - reach_s;
+    _traffic_bounds[i].s_max = max(s_start, s_end) + reach_s;
+    _traffic_bounds[i].d_min = _snapshot.d(i) - reach_d;
+    _traffic_bounds[i].d_max = _snapshot.d(i) + reach_d;
   }
-  return cost;
 }
 
-// penalizes low average speeds compared to speed limit
-double PolyTrajectoryGenerator::efficiency_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double s_dist = goal[0] - traj.first.eval(0);
-  double max_dist = _delta_s_maxspeed;
-  return abs(logistic((max_dist - s_dist) / max_dist)); // abs() because going faster is actually bad
+SweptBox PolyTrajectoryGenerator::swept_box(pair<QuinticPolynomial, QuinticPolynomial> const &traj) const {
+  SweptBox box;
+  traj.first.bounds(0.0, _horizon - 1, box.s_min, box.s_max);
+  traj.second.bounds(0.0, _horizon - 1, box.d_min, box.d_max);
+  return box;
 }
 
-double PolyTrajectoryGenerator::total_accel_s_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
+// integrates the traffic buffer cost over intervals in which the s gap keeps its sign,
+// using 5-point Gauss-Legendre quadrature on pieces of at most 16 timesteps
+double PolyTrajectoryGenerator::integrate_buffer_cost(QuinticPolynomial const &gap_s, TimeIntervals const &intervals, double sign) {
+  const double nodes[5] = {0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640};
+  const double weights[5] = {0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891};
   double cost = 0.0;
-  for (int t = 0; t < _horizon; t++) {
-    cost += abs(traj.first.eval_double_d(t));
+  for (int i = 0; i < intervals.size(); i++) {
+    int pieces = int(ceil((intervals.end(i) - intervals.begin(i)) / 16.0));
+    double half_width = 0.5 * (intervals.end(i) - intervals.begin(i)) / pieces;
+    for (int j = 0; j < pieces; j++) {
+      double mid = intervals.begin(i) + (2 * j + 1) * half_width;
+      for (int k = 0; k < 5; k++) {
+        double dif_s = sign * gap_s.eval(mid + half_width * nodes[k]);
+        cost += weights[k] * half_width * logistic(1 - (dif_s / _col_buf_length));
+      }
+    }
   }
-  return logistic(cost);
+  return cost;
 }
 
-double PolyTrajectoryGenerator::total_accel_d_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double cost = 0.0;
-  for (int t = 0; t < _horizon; t++) {
-    cost += abs(traj.second.eval_double_d(t));
+// collision check and traffic buffer cost for every vehicle, from the exact time intervals in which
+// the s and d gaps to it are inside the envelopes rather than from samples.
+// Same rules as the sampled version in evaluate_trajectory(). Does nothing in CHECK_SAMPLED mode.
+bool PolyTrajectoryGenerator::evaluate_traffic(pair<QuinticPolynomial, QuinticPolynomial> const &traj, vector<Vehicle> const &vehicles, TrajectoryEval &eval) {
+  if (_collision_check_mode == CHECK_SAMPLED)
+    return true;
+  QuinticPolynomial const &ego_s = traj.first;
+  QuinticPolynomial const &ego_d = traj.second;
+  const double t_end = _horizon - 1;
+  const double col_length = _car_col_length * 5.0;
+  const double col_width = _car_col_width * 3.0;
+  const double reach = max(col_length, _col_buf_length);
+  SweptBox box = swept_box(traj);
+  for (int i = 0; i < _snapshot.size(); i++) {
+    // vehicles that can't come close in s and d at any time
+    if (!box.overlaps(_traffic_bounds[i]))
+      continue;
+    QuinticPolynomial gap_s = QuinticPolynomial(_snapshot.s_trajectory(i)) - ego_s;
+    // never close enough for either check
+    TimeIntervals near = TimeIntervals::above(gap_s, -reach, 0.0, t_end).intersect(TimeIntervals::below(gap_s, reach, 0.0, t_end));
+    if (near.empty())
+      continue;
+    double traffic_d = _snapshot.d(i);
+    
+    // Ignore (potentially faster) vehicles from behind or that have fallen behind
+    TimeIntervals same_lane = TimeIntervals::above(ego_d, traffic_d - 2.0, 0.0, t_end).intersect(TimeIntervals::below(ego_d, traffic_d + 2.0, 0.0, t_end));
+    TimeIntervals other_lane = TimeIntervals::below(ego_d, traffic_d - 2.0, 0.0, t_end).unite(TimeIntervals::above(ego_d, traffic_d + 2.0, 0.0, t_end));
+    TimeIntervals fallen_behind = TimeIntervals::below(gap_s, -5.0, 0.0, t_end).intersect(same_lane).unite(
+                                  TimeIntervals::below(gap_s, -15.0, 0.0, t_end).intersect(other_lane));
+    double t_col_end = fallen_behind.first_begin(t_end);
+    // make the envelope a little wider to stay "out of trouble"
+    TimeIntervals col_s = TimeIntervals::above(gap_s, -col_length, 0.0, t_col_end).intersect(TimeIntervals::below(gap_s, col_length, 0.0, t_col_end));
+    if (!col_s.empty()) {
+      TimeIntervals col_d = TimeIntervals::above(ego_d, traffic_d - col_width, 0.0, t_col_end).intersect(TimeIntervals::below(ego_d, traffic_d + col_width, 0.0, t_col_end));
+      if (!col_s.intersect(col_d).empty())
+        return false;
+    }
+    
+    // if in the same lane and too close
+    double t_buf_end = TimeIntervals::below(gap_s, -10.0, 0.0, t_end).first_begin(t_end);
+    TimeIntervals buf_d = TimeIntervals::above(ego_d, traffic_d - _col_buf_width, 0.0, t_buf_end).intersect(TimeIntervals::below(ego_d, traffic_d + _col_buf_width, 0.0, t_buf_end));
+    if (buf_d.empty())
+      continue;
+    TimeIntervals ahead = TimeIntervals::above(gap_s, 0.0, 0.0, t_buf_end).intersect(TimeIntervals::below(gap_s, _col_buf_length, 0.0, t_buf_end));
+    TimeIntervals behind = TimeIntervals::below(gap_s, 0.0, 0.0, t_buf_end).intersect(TimeIntervals::above(gap_s, -_col_buf_length, 0.0, t_buf_end));
+    eval.traffic_buffer += (integrate_buffer_cost(gap_s, ahead.intersect(buf_d), 1.0) +
+                            integrate_buffer_cost(gap_s, behind.intersect(buf_d), -1.0)) / _horizon;
   }
-  return logistic(cost);
+  return true;
 }
 
-double PolyTrajectoryGenerator::total_jerk_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double cost = 0.0;
-  for (int t = 0; t < _horizon; t++) {
-    cost += abs(traj.first.eval_triple_d(t));
-    cost += abs(traj.second.eval_triple_d(t));
+// walks the sampled position, velocity, acceleration and jerk of s and d of candidate traj_i once
+// and updates all feasibility checks and per-timestep cost accumulators in that same pass.
+// Returns false as soon as the trajectory turns out to be infeasible.
+bool PolyTrajectoryGenerator::evaluate_trajectory(TrajectorySamples const &samples, int traj_i, vector<Vehicle> const &vehicles, TrajectoryEval &eval) {
+  // vehicles stop being considered once they have fallen behind
+  // (separately for collision and traffic buffer, same as the single-purpose cost functions).
+  // That time is only looked up for vehicles that come close. Every candidate has its own
+  // scratch space, so candidates can be evaluated concurrently. It only exists in CHECK_SAMPLED mode.
+  bool check_limits = (_limit_check_mode == CHECK_SAMPLED);
+  bool check_traffic = (_collision_check_mode == CHECK_SAMPLED);
+  int num_vehicles = _snapshot.size();
+  int *col_done_t = nullptr;
+  int *buf_done_t = nullptr;
+  int *nearby = nullptr;
+  if (check_traffic) {
+    col_done_t = _traffic_scratch.data() + 3 * traj_i * num_vehicles;
+    buf_done_t = col_done_t + num_vehicles;
+    nearby = buf_done_t + num_vehicles;
+    std::fill(col_done_t, col_done_t + 2 * num_vehicles, -1);
   }
-  return logistic(cost);
-}
-
-double PolyTrajectoryGenerator::lane_depart_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double cost = 0.0;
+  const double reach_s = max(_car_col_length * 5.0, _col_buf_length);
+  const double reach_d = max(_car_col_width * 3.0, _col_buf_width);
   for (int t = 0; t < _horizon; t++) {
-    double ego_d = traj.second.eval(t);
+    double ego_s       = samples.s(t, traj_i);
+    double ego_s_vel   = samples.s_vel(t, traj_i);
+    double ego_s_acc   = samples.s_acc(t, traj_i);
+    double ego_s_jerk  = samples.s_jerk(t, traj_i);
+    double ego_d       = samples.d(t, traj_i);
+    double ego_d_vel   = samples.d_vel(t, traj_i);
+    double ego_d_acc   = samples.d_acc(t, traj_i);
+    double ego_d_jerk  = samples.d_jerk(t, traj_i);
+
+    // situations that immediately make a trajectory infeasible
+    if (check_limits) {
+      if (ego_s_vel + ego_d_vel > _hard_max_vel_per_timestep)
+        return false;
+      if (ego_s_acc + ego_d_acc > _hard_max_acc_per_timestep)
+        return false;
+      if (ego_s_jerk + ego_d_jerk > _hard_max_jerk_per_timestep)
+        return false;
+    }
+
+    eval.accel_s += abs(ego_s_acc);
+    eval.accel_d += abs(ego_d_acc);
+    eval.jerk += abs(ego_s_jerk) + abs(ego_d_jerk);
+
     double lane_marking_proximity = fmod(ego_d, 4);
     if (lane_marking_proximity > 2.0)
       lane_marking_proximity = abs(lane_marking_proximity - 4);
     if (lane_marking_proximity <= _car_col_width) // car touches middle lane
-      cost += 1 - logistic(lane_marking_proximity);
-  }
-  return cost;
-}
+      eval.lane_depart += 1 - logistic(lane_marking_proximity);
 
-// nudges vehicle to proactively depart lanes with traffic ahead and prevent changing into busy lanes
-double PolyTrajectoryGenerator::traffic_ahead_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles) {
-  double ego_s = traj.first.eval(0);
-  double ego_d = traj.second.eval(0);
-  double ego_d_end = traj.second.eval(_horizon);
-  int look_ahead = 400;
-  
-  int fut_lane_i = 0;
-  if (ego_d_end > 8) fut_lane_i = 2;
-  else if (ego_d_end > 4) fut_lane_i = 1;
-  int closest_veh_fut_i = closest_vehicle_in_lane({ego_s, ego_d_end}, fut_lane_i, vehicles);
-  // if there is a vehicle in the lane the trajectory will take us to
-  if (closest_veh_fut_i != -1) {
-    vector<double> fut_traffic_s = vehicles[closest_veh_fut_i].get_s();
-    float dif_s = fut_traffic_s[0] - ego_s;
-    if (dif_s < look_ahead) {
-      // don't switch into a lane with slower traffic ahead
-      int cur_lane_i = 0;
-      if (ego_d > 8) cur_lane_i = 2;
-      else if (ego_d > 4) cur_lane_i = 1;
-      int closest_veh_i = closest_vehicle_in_lane({ego_s, ego_d_end}, cur_lane_i, vehicles);
-      // if there is a vehicle in the current lane AND make range a bit tighter
-      if ((closest_veh_i != -1) && (dif_s < look_ahead / 2.0)) {
-        vector<double> traffic_s = vehicles[closest_veh_i].get_s();
-        double ego_s_vel = traj.first.eval_d(0);
-        // traffic in planned lane clearly slower than in current?
-        if (fut_traffic_s[1] < traffic_s[1] * 0.95)
-          return 1000;
-      }
-      // end - don't switch into a lane with slower traffic ahead
-      
-      // no slower traffic in goal lane, so return regular cost
-      return logistic(1 - (dif_s / look_ahead));
+    if (!check_traffic)
+      continue;
+    // vehicles in reach of either check. Lanes are clamped the same way for ego and traffic,
+    // so every vehicle within reach_d is in one of the lanes the ego envelope touches.
+    int num_nearby = 0;
+    for (int lane = lane_of(ego_d - reach_d); lane <= lane_of(ego_d + reach_d); lane++) {
+      OccupiedInterval const *begin, *end;
+      _traffic.overlapping(t, lane, ego_s - reach_s, ego_s + reach_s, begin, end);
+      for (OccupiedInterval const *interval = begin; interval != end; interval++)
+        nearby[num_nearby++] = interval->vehicle;
+    }
+    // in vehicle order, so the buffer cost adds up as it would over all vehicles
+    std::sort(nearby, nearby + num_nearby);
+    for (int k = 0; k < num_nearby; k++) {
+      int i = nearby[k];
+      if (col_done_t[i] < 0)
+        fallen_behind(samples, traj_i, i, col_done_t[i], buf_done_t[i]);
+      double dif_s = _traffic.s(t, i) - ego_s;
+      double dif_d = abs(_traffic.d(t, i) - ego_d);
+
+      // make the envelope a little wider to stay "out of trouble"
+      if ((t < col_done_t[i]) && (abs(dif_s) <= _car_col_length * 5.0) && (dif_d <= _car_col_width * 3.0))
+        return false;
+
+      // if in the same lane and too close
+      if ((t < buf_done_t[i]) && (abs(dif_s) <= _col_buf_length) && (dif_d <= _col_buf_width))
+        eval.traffic_buffer += logistic(1 - (abs(dif_s) / _col_buf_length)) / _horizon;
     }
   }
-  return 0.0;
+  return true;
 }
 
+// first timesteps at which a vehicle has fallen behind candidate traj_i, for the collision
+// and the traffic buffer check. _horizon if it never does.
+void PolyTrajectoryGenerator::fallen_behind(TrajectorySamples const &samples, int traj_i, int vehicle, int &col_t, int &buf_t) const {
+  col_t = _horizon;
+  buf_t = _horizon;
+  for (int t = 0; (t < _horizon) && ((col_t == _horizon) || (buf_t == _horizon)); t++) {
+    double dif_s = _traffic.s(t, vehicle) - samples.s(t, traj_i);
+    double dif_d = abs(_traffic.d(t, vehicle) - samples.d(t, traj_i));
+    // Ignore (potentially faster) vehicles from behind or that have fallen behind
+    if ((col_t == _horizon) && (((dif_s < -5) && (dif_d < 2.0)) || (((dif_s < -15) && (dif_d > 2.0)))))
+      col_t = t;
+    if ((buf_t == _horizon) && (dif_s < -10))
+      buf_t = t;
+  }
+}
 
-double PolyTrajectoryGenerator::calculate_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles, vector<vector<double>> &all_costs) {
-  Polynomial s = traj.first;
-  Polynomial d = traj.second;
-    
+double PolyTrajectoryGenerator::calculate_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, TrajectorySamples const &samples, int traj_i, Goal const &goal, vector<Vehicle> const &vehicles, CostTerms &cost_terms) {
   double cost = 0.0;
-  // first situations that immediately make a trajectory infeasible
-  double ex_sp_lim_cost = exceeds_speed_limit_cost(traj, goal, vehicles);
-  double ex_acc_lim_cost = exceeds_accel_cost(traj, goal, vehicles);
-  double ex_jerk_lim_cost = exceeds_jerk_cost(traj, goal, vehicles);
-  double col_cost = collision_cost(traj, goal, vehicles);
-  
-  double infeasible_costs = ex_sp_lim_cost + ex_acc_lim_cost + ex_jerk_lim_cost + col_cost;
-  if (infeasible_costs > 0.0) {
-    all_costs.push_back({999999});
+  TrajectoryEval eval;
+  bool feasible = false;
+  if (!PTG_TIMED(STAGE_CHECK_LIMITS, within_dynamic_limits(traj)))
+    PTG_COUNT(COUNT_REJECT_LIMITS, 1);
+  else if (!PTG_TIMED(STAGE_CHECK_TRAFFIC, evaluate_traffic(traj, vehicles, eval)))
+    PTG_COUNT(COUNT_REJECT_TRAFFIC, 1);
+  else if (!PTG_TIMED(STAGE_CHECK_TRAJECTORY, evaluate_trajectory(samples, traj_i, vehicles, eval)))
+    PTG_COUNT(COUNT_REJECT_TRAJECTORY, 1);
+  else
+    feasible = true;
+  if (!feasible) {
+    cost_terms.fill(0.0);
     return 999999;
-  }  
-  
-  double tr_buf_cost   = traffic_buffer_cost(traj, goal, vehicles) * _cost_weights["tr_buf_cost"];
-  double eff_cost      = efficiency_cost(traj, goal, vehicles) * _cost_weights["eff_cost"];
-  double acc_s_cost    = total_accel_s_cost(traj, goal, vehicles) * _cost_weights["acc_s_cost"];
-  double acc_d_cost    = total_accel_d_cost(traj, goal, vehicles) * _cost_weights["acc_d_cost"];
-  double jerk_cost     = total_jerk_cost(traj, goal, vehicles) * _cost_weights["jerk_cost"];
-  double lane_dep_cost = lane_depart_cost(traj, goal, vehicles) * _cost_weights["lane_dep_cost"];
-//  double lane_dep_cost = 0.0;
-  double traffic_cost  = traffic_ahead_cost(traj, goal, vehicles) * _cost_weights["traffic_cost"];
-  
-  vector<double> cost_vec = {tr_buf_cost, eff_cost, acc_s_cost, acc_d_cost, jerk_cost, lane_dep_cost, traffic_cost};
-  all_costs.push_back(cost_vec);
+  }
   
-  cost = tr_buf_cost + eff_cost + acc_s_cost + acc_d_cost + jerk_cost + lane_dep_cost + traffic_cost;
+  CostContext context = {this, traj, goal, vehicles, eval};
+  cost = _cost_policy.evaluate(context, cost_terms);
   return cost;
 }
 
@@ -211,33 +313,20 @@ double PolyTrajectoryGenerator::logistic(double x) {
     return (2.0 / (1 + exp(-x)) - 1.0);
 }
 
-// searches for closest vehicle in current travel lane. Returns index and s-distance.
-int PolyTrajectoryGenerator::closest_vehicle_in_lane(vector<double> const &start, int ego_lane_i, vector<Vehicle> const &vehicles) {
-  int closest_i = -1;
-  float min_s_dif = 999;
-  for (int i = 0; i < vehicles.size(); i++) {
-    vector<double> traffic_d = vehicles[i].get_d();
-    int traffic_lane_i = 0;
-    if (traffic_d[0] > 8) traffic_lane_i = 2;
-    else if (traffic_d[0] > 4) traffic_lane_i = 1;
-    
-    if (ego_lane_i == traffic_lane_i) {
-      vector<double> traffic_s = vehicles[i].get_s();
-      float dif_s = traffic_s[0] - start[0];
-      if ((dif_s > 0.0) && (dif_s < min_s_dif)) {
-        closest_i = i;
-        min_s_dif = dif_s;
-      }        
-    }
-  }
-  return closest_i;
+// searches for closest vehicle in current travel lane. Returns its index in vehicles, -1 if there is none.
+// Looks it up in the snapshot of the current cycle, which was built from vehicles.
+int PolyTrajectoryGenerator::closest_vehicle_in_lane(double start_s, int ego_lane_i, vector<Vehicle> const &vehicles) {
+  int closest_i = _snapshot.leader(ego_lane_i, start_s);
+  if ((closest_i == -1) || (float(_snapshot.s(closest_i) - start_s) >= _look_ahead_range))
+    return -1;
+  return _snapshot.source(closest_i);
 }
 
 // searches for closest vehicle in current travel lane. Returns index and s-distance.
-vector<int> PolyTrajectoryGenerator::closest_vehicle_in_lanes(vector<double> const &start, vector<Vehicle> const &vehicles) {
-  vector<int> closest_veh_i(3);
+array<int, 3> PolyTrajectoryGenerator::closest_vehicle_in_lanes(double start_s, vector<Vehicle> const &vehicles) {
+  array<int, 3> closest_veh_i;
   for (int i = 0; i < 3; i++)
-    closest_veh_i[i] = closest_vehicle_in_lane(start, i, vehicles);
+    closest_veh_i[i] = closest_vehicle_in_lane(start_s, i, vehicles);
   return closest_veh_i;
 }
 
@@ -245,11 +334,107 @@ string PolyTrajectoryGenerator::get_current_action() {
   return _current_action;
 }
 
+void PolyTrajectoryGenerator::set_limit_check_mode(CheckMode mode) {
+  _limit_check_mode = mode;
+}
+
+void PolyTrajectoryGenerator::set_collision_check_mode(CheckMode mode) {
+  _collision_check_mode = mode;
+}
+
+void PolyTrajectoryGenerator::set_seed(unsigned int seed) {
+  _sampler.seed(seed);
+}
+
+void PolyTrajectoryGenerator::set_sampling_mode(SamplingMode mode) {
+  _sampler.set_mode(mode);
+}
+
+void PolyTrajectoryGenerator::set_goal_samples(int samples) {
+  _goal_perturb_samples = samples;
+}
+
+void PolyTrajectoryGenerator::set_refinement(int samples, int elites) {
+  _refine_samples = samples;
+  _refine_elites = elites;
+}
+
+void PolyTrajectoryGenerator::set_candidate_budget(int max_candidates) {
+  _candidate_budget = max_candidates;
+}
+
+void PolyTrajectoryGenerator::set_time_budget(double milliseconds) {
+  _time_budget_ms = milliseconds;
+}
+
+void PolyTrajectoryGenerator::set_warm_start(int seeds, int steady_samples) {
+  _warm_start_seeds = seeds;
+  _warm_start_samples = steady_samples;
+  if (seeds == 0)
+    _warm_goals.clear();
+}
+
+PlannerStats PolyTrajectoryGenerator::get_stats() const {
+  PlannerStats stats = PlannerInstrumentation::instance().snapshot();
+  stats.num_cost_terms = PlannerCostPolicy::size;
+  for (int i = 0; i < PlannerCostPolicy::size; i++)
+    stats.cost_term_names[i] = PlannerCostPolicy::name(i);
+  return stats;
+}
+
+void PolyTrajectoryGenerator::reset_stats() {
+  PlannerInstrumentation::instance().reset();
+}
+
+#ifdef PTG_TUNABLE_COST_WEIGHTS
+bool PolyTrajectoryGenerator::set_cost_weight(std::string const &name, double weight) {
+  for (int i = 0; i < PlannerCostPolicy::size; i++) {
+    if (name == PlannerCostPolicy::name(i)) {
+      _cost_policy.set_weight(i, weight);
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+void PolyTrajectoryGenerator::set_num_threads(int num_threads) {
+  if (num_threads > 1)
+    _thread_pool.reset(new ThreadPool(num_threads));
+  else
+    _thread_pool.reset();
+}
+
 // returns: trajectory for given number of timesteps (horizon) in Frenet coordinates
-vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<double> const &start, double max_speed, double horizon, vector<Vehicle> const &vehicles) { 
-  const vector<double> start_s = {start[0], start[1], start[2]};
-  const vector<double> start_d = {start[3], start[4], start[5]};
+vector<vector<double>> const &PolyTrajectoryGenerator::generate_trajectory(vector<double> const &start, double max_speed, double horizon, vector<Vehicle> const &vehicles) { 
+  PTG_TIME_STAGE(STAGE_CYCLE);
+  PTG_STAGE_BEGIN(situation_timer, STAGE_SITUATION);
+  PTG_COUNT(COUNT_CYCLES, 1);
+  _deadline = chrono::steady_clock::now() + chrono::microseconds(int64_t(1000.0 * _time_budget_ms));
   _horizon = horizon;
+  // size all buffers for this cycle up front. Only a cycle that had to grow one may touch the heap.
+  bool buffers_grew = _arena.reset();
+  // everything after this only looks at the vehicles the snapshot keeps
+  buffers_grew = _snapshot.reserve(vehicles.size()) || buffers_grew;
+  _snapshot.build(vehicles, start[0], _look_ahead_range, 2.0 * _horizon * _hard_max_vel_per_timestep,
+                  max(_car_col_length * 5.0, _col_buf_length), _horizon);
+  buffers_grew = reserve_buffers(_snapshot.size()) || buffers_grew;
+#ifdef PTG_COUNT_ALLOCATIONS
+  uint64_t heap_allocations = heap_allocation_count();
+  Eigen::internal::set_is_malloc_allowed(buffers_grew || (_cycles == 0));
+#endif
+  _cycles++;
+  _start_s.assign(start.begin(), start.begin() + 3);
+  _start_d.assign(start.begin() + 3, start.begin() + 6);
+  vector<double> const &start_s = _start_s;
+  vector<double> const &start_d = _start_d;
+  _time_basis.set_horizon(_horizon);
+  _jmt_solver.set_horizon(_horizon);
+  update_traffic_bounds();
+  // the time-major table is only looked at by the sampled collision check, the analytic one
+  // works on the snapshot's polynomials
+  if (_collision_check_mode == CHECK_SAMPLED)
+    _traffic.predict(_snapshot, _horizon, _car_length);
   _max_dist_per_timestep = 0.00894 * max_speed;
   
   _delta_s_maxspeed = _horizon * _max_dist_per_timestep;
@@ -262,15 +447,12 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
   
   // figure out current lane
   // 0: left, 1: middle, 2: right
-  int cur_lane_i = 0;
-  if (start_d[0] > 8) cur_lane_i = 2;
-  else if (start_d[0] > 4) cur_lane_i = 1;
+  int cur_lane_i = lane_of(start_d[0]);
   
   cout << "ego local s: " << start_s[0] << " s_vel: " << start_s[1] << " d: " << start_d[0] << endl;
   
-  vector<vector<double>> goal_points;
-  vector<vector<double>> traj_goals; // s, s_dot, s_double_dot, d, d_dot, d_double_dot
-  vector<double> traj_costs;
+  GoalList goal_points(_arena);
+  goal_points.reserve(max_goals_per_batch());
   
   // #########################################
   // FIND FEASIBLE NEXT STATES FROM:
@@ -284,14 +466,15 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
   bool change_left = false;
   bool change_right = false;
   // get closest vehicle for each lane
-  vector<int> closest_veh_i = closest_vehicle_in_lanes(start, vehicles);
+  array<int, 3> closest_veh_i = closest_vehicle_in_lanes(start_s[0], vehicles);
 
-  cout << "closest veh i " << closest_veh_i[cur_lane_i] << " - position s: " << vehicles[closest_veh_i[cur_lane_i]].get_s()[0] << " - position d: " << vehicles[closest_veh_i[cur_lane_i]].get_d()[0] << endl;
+  if (closest_veh_i[cur_lane_i] != -1)
+    cout << "closest veh i " << closest_veh_i[cur_lane_i] << " - position s: " << vehicles[closest_veh_i[cur_lane_i]].s_at(0) << " - position d: " << vehicles[closest_veh_i[cur_lane_i]].d_at(0) << endl;
   
   if (closest_veh_i[cur_lane_i] != -1) {
-    vector<double> closest_veh_s = vehicles[closest_veh_i[cur_lane_i]].get_s();
+    Vehicle const &closest_veh = vehicles[closest_veh_i[cur_lane_i]];
     // there is some traffic ahead
-    if (abs(closest_veh_s[0] - start_s[0]) < 100) {
+    if (abs(closest_veh.s_at(0) - start_s[0]) < 100) {
       change_left = true;
       change_right = true;
       // do not change lane if:
@@ -301,21 +484,21 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
       if (cur_lane_i == 1) { 
         // left change
         if (closest_veh_i[0] != -1) {
-          vector<double> closest_veh_left = vehicles[closest_veh_i[0]].get_s();
-          if ((closest_veh_s[1] * 1.05 >= closest_veh_left[1]) && (closest_veh_left[0] <  closest_veh_s[0] + 50)) {
+          Vehicle const &closest_veh_left = vehicles[closest_veh_i[0]];
+          if ((closest_veh.s_vel() * 1.05 >= closest_veh_left.s_vel()) && (closest_veh_left.s_at(0) <  closest_veh.s_at(0) + 50)) {
             change_left = false;
           }
         }
         if (closest_veh_i[2] != -1) {
-          vector<double> closest_veh_right = vehicles[closest_veh_i[2]].get_s();
-          if ((closest_veh_s[1] * 1.05 >= closest_veh_right[1]) && (closest_veh_right[0] <  closest_veh_s[0] + 50)) {
+          Vehicle const &closest_veh_right = vehicles[closest_veh_i[2]];
+          if ((closest_veh.s_vel() * 1.05 >= closest_veh_right.s_vel()) && (closest_veh_right.s_at(0) <  closest_veh.s_at(0) + 50)) {
             change_right = false;
           }
         }        
       }
     }
     // there is a vehicle close ahead    
-    if (abs(closest_veh_s[0] - start_s[0]) < _col_buf_length * 1.3) {
+    if (abs(closest_veh.s_at(0) - start_s[0]) < _col_buf_length * 1.3) {
       go_straight = false;
       go_straight_follow_lead = true;
       change_left = true;
@@ -352,35 +535,88 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
 //    }
   }
   
+  // what the planner made of the traffic around it. Warm start seeds are only trusted while this stays the same.
+  int situation = cur_lane_i | (go_straight << 2) | (go_straight_follow_lead << 3) | (change_left << 4) | (change_right << 5) | (prefer_mid_lane << 6);
+  for (int i = 0; i < 3; i++) {
+    if ((closest_veh_i[i] != -1) && (vehicles[closest_veh_i[i]].s_at(0) - start_s[0] < 100))
+      situation |= 1 << (7 + i);
+  }
+  PTG_STAGE_END(situation_timer);
+  
+  // #########################################
+  // FALLBACK LADDER
+  // #########################################
+  // Every rung only adds goals the earlier ones didn't cover, candidates evaluated so far are kept:
+  // 0: goal families of the current situation (and last cycle's best goals)
+  // 1: all maneuvers
+  // 2, 3: keep lane at 80% and 64% of the speed limit
+  // If nothing is feasible after that, the first goal of the last rung is driven anyway.
+  // All rungs together evaluate at most _candidate_budget candidates, plus the first goal of each rung.
+  // A rung that has nothing new to add costs nothing.
+  bool has_lead = (closest_veh_i[cur_lane_i] != -1);
+  bool straight_done = false;
+  bool follow_done = false;
+  bool left_done = false;
+  bool right_done = false;
+  // anytime mode tries the lane change into the lane with more room ahead first
+  int family_order[FAMILY_COUNT] = {FAMILY_STRAIGHT, FAMILY_FOLLOW, FAMILY_LEFT, FAMILY_RIGHT};
+  if (room_ahead(start_s[0], 2, closest_veh_i, vehicles) > room_ahead(start_s[0], 0, closest_veh_i, vehicles))
+    std::swap(family_order[2], family_order[3]);
   double min_cost = 999999;
   int min_cost_i = 0;
-  vector<vector<double>> all_costs;
-  vector<pair<Polynomial, Polynomial>> trajectory_coefficients;
-  int path_fail_count = 0;
+  int rung = 0;
+  int rung_first = 0;
+  _candidates.clear();
   while (min_cost == 999999) {
+    if (rung > 0)
+      PTG_COUNT(COUNT_RETRIES, 1);
+    rung_first = _candidates.size();
+    // #########################################
+    // WARM START
+    // #########################################
+    _cycle_perturb_samples = _goal_perturb_samples;
+    if (rung == 0) {
+      GoalList seed_goal_points(_arena);
+      seed_goal_points.reserve(_warm_start_seeds);
+      warm_start_goals(start_s, seed_goal_points);
+      evaluate_goals(start_s, start_d, seed_goal_points, vehicles, prefer_mid_lane);
+      // nothing material changed: the seeds are still near-optimal, fewer fresh goals will do
+      bool seeds_feasible = (_candidates.size() > 0);
+      for (int i = 0; i < _candidates.size(); i++)
+        seeds_feasible = seeds_feasible && (_candidates.costs[i] != 999999);
+      if (seeds_feasible && (situation == _warm_situation))
+        _cycle_perturb_samples = min(_warm_start_samples, _goal_perturb_samples);
+    }
+    
+    PTG_STAGE_BEGIN(goals_timer, STAGE_GOALS);
     goal_points.clear();
+    // goals of every family are [family_begin, family_end)
+    int family_begin[FAMILY_COUNT] = {0, 0, 0, 0};
+    int family_end[FAMILY_COUNT] = {0, 0, 0, 0};
     // #########################################
     // GENERATE GOALPOINTS
     // #########################################
     // GO STRAIGHT
-    if (go_straight) {
+    if (go_straight && !straight_done) {
+      straight_done = true;
+      family_begin[FAMILY_STRAIGHT] = goal_points.size();
       double goal_s_pos = start_s[0] + _delta_s_maxspeed;
       double goal_s_vel = _max_dist_per_timestep;
       double goal_s_acc = 0.0;
       double goal_d_pos = 2 + 4 * cur_lane_i;
       double goal_d_vel = 0.0;
       double goal_d_acc = 0.0;
-      vector<double> goal_vec = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};    
-      vector<vector<double>> goal_points_straight = {goal_vec};
-      perturb_goal(goal_vec, goal_points_straight);
-      // add to goal points
-      goal_points.reserve(goal_points.size() + goal_points_straight.size());
-      goal_points.insert(goal_points.end(),goal_points_straight.begin(),goal_points_straight.end());
+      Goal goal = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
+      goal_points.push_back(goal);
+      perturb_goal(goal, goal_points);
+      family_end[FAMILY_STRAIGHT] = goal_points.size();
     }
 
     // FOLLOW OTHER VEHICLE
-    if (go_straight_follow_lead) {
-      vector<double> lead_s = vehicles[closest_veh_i[cur_lane_i]].get_s();
+    if (go_straight_follow_lead && has_lead && !follow_done) {
+      follow_done = true;
+      family_begin[FAMILY_FOLLOW] = goal_points.size();
+      double lead_s_vel = vehicles[closest_veh_i[cur_lane_i]].s_vel();
 
       // "EMERGENCY BREAK ASSIST" to the drive assist
       // if much slower vehicle pulls into lane dangerously close in front of us,
@@ -393,30 +629,30 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
 //        change_left = false;
 //        change_right = false;
 //      }      
-      double goal_s_pos = start_s[0] + lead_s[1] * _horizon;
-      double goal_s_vel = lead_s[1];
+      double goal_s_pos = start_s[0] + lead_s_vel * _horizon;
+      double goal_s_vel = lead_s_vel;
       double goal_s_acc = 0.0;
       double goal_d_pos = 2 + 4 * cur_lane_i;
       double goal_d_vel = 0.0;
       double goal_d_acc = 0.0;
-      vector<double> goal_vec = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
-      vector<vector<double>> goal_points_follow = {goal_vec};
-      perturb_goal(goal_vec, goal_points_follow);
-      // add to goal points
-      goal_points.reserve(goal_points.size() + goal_points_follow.size());
-      goal_points.insert(goal_points.end(),goal_points_follow.begin(),goal_points_follow.end());
+      Goal goal = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
+      goal_points.push_back(goal);
+      perturb_goal(goal, goal_points);
+      family_end[FAMILY_FOLLOW] = goal_points.size();
     }
     
     double lane_change_slowdown = 0.98;
     // CHANGE LANE LEFT
-    if (change_left && (cur_lane_i != 0)) {
+    if (change_left && (cur_lane_i != 0) && !left_done) {
+      left_done = true;
+      family_begin[FAMILY_LEFT] = goal_points.size();
 //      double goal_s_pos = start_s[0] + _delta_s_maxspeed * lane_change_slowdown * cur_speed_fac;
 //      double goal_s_vel = _max_dist_per_timestep * lane_change_slowdown * cur_speed_fac;
       double goal_s_pos = start_s[0] + start_s[1] * _horizon * lane_change_slowdown;
       double goal_s_vel = start_s[1] * lane_change_slowdown;
       // less aggressive lane change if we are already following
 //      if (go_straight_follow_lead) {
-//        vector<double> lead_s = vehicles[closest_veh_i[cur_lane_i]].get_s();
+//        double lead_s_vel = vehicles[closest_veh_i[cur_lane_i]].s_vel();
 //        // but only if following closely
 ////        if (lead_s[0] - start_s[0] < _col_buf_length * 1.0) {
 //          goal_s_pos = start_s[0] + lead_s[1] * _horizon;
@@ -427,43 +663,45 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
       double goal_d_pos = (2 + 4 * cur_lane_i) - 4;
       double goal_d_vel = 0.0;
       double goal_d_acc = 0.0;
-      vector<double> goal_vec = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
-      vector<vector<double>> goal_points_left = {goal_vec};
-      perturb_goal(goal_vec, goal_points_left, true);
-      // add to goal points
-      goal_points.reserve(goal_points.size() + goal_points_left.size());
-      goal_points.insert(goal_points.end(),goal_points_left.begin(),goal_points_left.end());
+      Goal goal = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
+      goal_points.push_back(goal);
+      perturb_goal(goal, goal_points, true);
+      family_end[FAMILY_LEFT] = goal_points.size();
     }
 
     // CHANGE LANE RIGHT
-    if (change_right && (cur_lane_i != 2)) {
+    if (change_right && (cur_lane_i != 2) && !right_done) {
+      right_done = true;
+      family_begin[FAMILY_RIGHT] = goal_points.size();
 //      double goal_s_pos = start_s[0] + _delta_s_maxspeed * lane_change_slowdown * cur_speed_fac;
 //      double goal_s_vel = _max_dist_per_timestep * lane_change_slowdown * cur_speed_fac;
       double goal_s_pos = start_s[0] + start_s[1] * _horizon * lane_change_slowdown;
       double goal_s_vel = start_s[1] * lane_change_slowdown;
       // less aggressive lane change if we are already following
-      if (go_straight_follow_lead) {
-        vector<double> lead_s = vehicles[closest_veh_i[cur_lane_i]].get_s();
+      if (go_straight_follow_lead && has_lead) {
+        double lead_s_vel = vehicles[closest_veh_i[cur_lane_i]].s_vel();
         // but only if following closely
 //        if (lead_s[0] - start_s[0] < _col_buf_length * 0.5) {
-          goal_s_pos = start_s[0] + lead_s[1] * _horizon;
-          goal_s_vel = lead_s[1];
+          goal_s_pos = start_s[0] + lead_s_vel * _horizon;
+          goal_s_vel = lead_s_vel;
 //        }
       }
       double goal_s_acc = 0.0;
       double goal_d_pos = (2 + 4 * cur_lane_i) + 4;
       double goal_d_vel = 0.0;
       double goal_d_acc = 0.0;
-      vector<double> goal_vec = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
-      vector<vector<double>> goal_points_right = {goal_vec};
-      perturb_goal(goal_vec, goal_points_right);
-      // add to goal points
-      goal_points.reserve(goal_points.size() + goal_points_right.size());
-      goal_points.insert(goal_points.end(),goal_points_right.begin(),goal_points_right.end());
+      Goal goal = {goal_s_pos, goal_s_vel, goal_s_acc, goal_d_pos, goal_d_vel, goal_d_acc};
+      goal_points.push_back(goal);
+      perturb_goal(goal, goal_points);
+      family_end[FAMILY_RIGHT] = goal_points.size();
     }
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
     // END - GENERATE GOALPOINTS
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    if (_time_budget_ms > 0.0)
+      prioritize_goals(goal_points, family_begin, family_end, family_order);
+    limit_to_budget(goal_points, 1);
+    PTG_STAGE_END(goals_timer);
 
     cout << "PLAN: ";
     if (go_straight)
@@ -477,164 +715,377 @@ vector<vector<double>> PolyTrajectoryGenerator::generate_trajectory(vector<doubl
     cout << endl;
 
     // #########################################
-    // JERK MINIMIZED TRAJECTORIES
+    // JERK MINIMIZED TRAJECTORIES AND THEIR COST
     // #########################################
-    trajectory_coefficients.clear();
-    traj_goals.clear();
-    for (vector<double> goal : goal_points) {
-      vector<double> goal_s = {goal[0], goal[1], goal[2]};
-      vector<double> goal_d = {goal[3], goal[4], goal[5]};
-      // ignore goal points that are out of bounds
-      if ((goal[3] > 1.0) && (goal[3] < 11.0)) {      
-        Polynomial traj_s_poly = jmt(start_s, goal_s, _horizon);
-        Polynomial traj_d_poly = jmt(start_d, goal_d, _horizon);
-        trajectory_coefficients.push_back(std::make_pair(traj_s_poly, traj_d_poly));
-        traj_goals.push_back({goal[0], goal[1], goal[2], goal[3], goal[4], goal[5]});
-      }     
+    evaluate_goals(start_s, start_d, goal_points, vehicles, prefer_mid_lane);
+    // look for better goals around the best ones found so far
+    if (_refine_samples > 0) {
+      GoalList refined_goal_points(_arena);
+      refined_goal_points.reserve(_refine_samples);
+      PTG_TIMED(STAGE_GOALS, refine_goals(refined_goal_points));
+      limit_to_budget(refined_goal_points, 0);
+      evaluate_goals(start_s, start_d, refined_goal_points, vehicles, prefer_mid_lane);
     }
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
-    // END - JERK MINIMIZED TRAJECTORIES
+    // END - JERK MINIMIZED TRAJECTORIES AND THEIR COST
     // ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
-    // ################################
-    // COMPUTE COST FOR EACH TRAJECTORY
-    // ################################
-    all_costs.clear();
-    traj_costs.clear();
-    for (int i = 0; i < trajectory_coefficients.size(); i++) {
-      double cost = calculate_cost(trajectory_coefficients[i], traj_goals[i], vehicles, all_costs);
-      // if appropriate, scale costs for trajectories going to the middle lane
-      if (prefer_mid_lane && (cost != 999999)) {
-        // if we are currently not in middle lane AND trajectory takes us into middle lane
-        if ((abs(6 - trajectory_coefficients[i].second.eval(0)) > 1.0) && (abs(6 - trajectory_coefficients[i].second.eval(_horizon)) < 1.0)) {
-          cost *= 0.6;
-        }
-      }
-      traj_costs.push_back(cost);
-    }
-
-    // choose least-cost trajectory
-    min_cost = traj_costs[0];
+    // choose least-cost trajectory. Serial and in candidate order, so ties always resolve the same way.
+    min_cost = 999999;
     min_cost_i = 0;
-    for (int i = 1; i < trajectory_coefficients.size(); i++) {
-      if (traj_costs[i] < min_cost) {
-        min_cost = traj_costs[i];
+    for (int i = 0; i < _candidates.size(); i++) {
+      if (_candidates.costs[i] < min_cost) {
+        min_cost = _candidates.costs[i];
         min_cost_i = i;
       }
     }
+    // anytime mode: out of time with nothing feasible. The caller keeps driving its previous path.
+    if ((min_cost == 999999) && out_of_time()) {
+      PTG_COUNT(COUNT_OUT_OF_TIME, 1);
+      cout << "PLANNER: OUT OF TIME" << endl;
+      break;
+    }
 //     rare edge case: vehicle is stuck in infeasible trajectory
     if (min_cost == 999999) {
-      path_fail_count += 1;
-      change_left = true;
-      change_right = true;
-      go_straight_follow_lead = true;
       cout << "PLANNER: COULDN'T FIND PATH" << endl;
-      
-      // if it fails frequently, invoke slowdown
-      if (path_fail_count > 2) {
-//        if (go_straight_follow_lead) {
-//          if (closest_veh_i[cur_lane_i] != -1) {
-//            vector<double> lead_s = vehicles[closest_veh_i[cur_lane_i]].get_s();
-//            max_speed = lead_s[1];
-//          }
-//        }
+      rung++;
+      if (rung == _ladder_rungs) {
+        // the last rung always keeps lane, but make sure there is something to drive,
+        // even if the budget ran out since the check above
+        if (rung_first == _candidates.size()) {
+          GoalList keep_lane(_arena);
+          keep_lane.push_back({{start_s[0] + start_s[1] * _horizon, start_s[1], 0.0, 2.0 + 4 * cur_lane_i, 0.0, 0.0}});
+          evaluate_goals(start_s, start_d, keep_lane, vehicles, prefer_mid_lane, true);
+        }
+        assert(rung_first < _candidates.size());
+        min_cost = 99998;
+        min_cost_i = rung_first;
+      } else if (rung == 1) {
+        change_left = true;
+        change_right = true;
+        go_straight_follow_lead = true;
+      } else {
+        // invoke slowdown
         max_speed = max_speed * 0.8;
         _max_dist_per_timestep = 0.00894 * max_speed;
         _delta_s_maxspeed = _horizon * _max_dist_per_timestep;
-        if (path_fail_count > 3) {
-          min_cost = 99998;
-          min_cost_i = 0;
-        }
+        go_straight = true;
+        straight_done = false;
       }
-//      double min_s = trajectory_coefficients[0].first.eval(_horizon);
-//      int min_s_i = 0;
-//      // find trajectory going straight with minimum s
-//      for (int i = 1; i < _goal_perturb_samples; i++) {
-//        if (trajectory_coefficients[i].first.eval(_horizon) < min_s){
-//          min_s = trajectory_coefficients[i].first.eval(_horizon);
-//          min_s_i = i;
-//        }
-//      }
-//      min_cost_i = min_s_i;
     }
   }
   
+  if (min_cost < 99998)
+    store_warm_start(start_s, situation);
+  else
+    _warm_goals.clear();
+  if (min_cost == 999999) {
+    _new_traj[0].clear();
+    _new_traj[1].clear();
+#ifdef PTG_COUNT_ALLOCATIONS
+    Eigen::internal::set_is_malloc_allowed(true);
+    assert(buffers_grew || (_cycles == 1) || (heap_allocation_count() == heap_allocations));
+#endif
+    return _new_traj;
+  }
   
-  
-  cout << "cost: " << traj_costs[min_cost_i] << " - i: " << min_cost_i << endl;
-  cout << "traffic buffer cost: " << all_costs[min_cost_i][0] << endl;
-  cout << "efficiency cost: " << all_costs[min_cost_i][1] << endl;
-  cout << "acceleration s cost: " << all_costs[min_cost_i][2] << endl;
-  cout << "acceleration d cost: " << all_costs[min_cost_i][3] << endl;
-  cout << "jerk cost: " << all_costs[min_cost_i][4] << endl;
-  cout << "lane depart cost: " << all_costs[min_cost_i][5] << endl;
-  cout << "traffic cost: " << all_costs[min_cost_i][6] << endl;
-  cout << "lowest cost traj goal s/d: " << goal_points[min_cost_i][0] << " : " << goal_points[min_cost_i][3] << endl;
+  cout << "cost: " << _candidates.costs[min_cost_i] << " - i: " << min_cost_i << endl;
+  if (_candidates.costs[min_cost_i] != 999999) {
+    for (int i = 0; i < PlannerCostPolicy::size; i++)
+      cout << PlannerCostPolicy::name(i) << " cost: " << _candidates.cost_terms[min_cost_i][i] << endl;
+  }
+  cout << "lowest cost traj goal s/d: " << _candidates.goals[min_cost_i][0] << " : " << _candidates.goals[min_cost_i][3] << endl;
   // ################################
   // COMPUTE VALUES FOR TIME HORIZON
   // ################################
-  vector<double> traj_s(_horizon);
-  vector<double> traj_d(_horizon);
+  PTG_TIME_STAGE(STAGE_OUTPUT);
+  pair<QuinticPolynomial, QuinticPolynomial> const &min_cost_traj = _candidates.trajectories[min_cost_i];
+  vector<double> &traj_s = _new_traj[0];
+  vector<double> &traj_d = _new_traj[1];
+  traj_s.resize(_horizon);
+  traj_d.resize(_horizon);
   for(int t = 0; t < _horizon; t++) {
-      traj_s[t] = trajectory_coefficients[min_cost_i].first.eval(t);
-      traj_d[t] = trajectory_coefficients[min_cost_i].second.eval(t);
+      traj_s[t] = min_cost_traj.first.eval(t);
+      traj_d[t] = min_cost_traj.second.eval(t);
   }
   
   _current_action = "straight";
   if (abs(traj_d[0] - traj_d[_horizon-1]) > 2.0)
     _current_action = "lane_change";
   
-  vector<vector<double>> new_traj(2);
-  new_traj[0] = traj_s;
-  new_traj[1] = traj_d;
-  
-  return new_traj;
+#ifdef PTG_COUNT_ALLOCATIONS
+  Eigen::internal::set_is_malloc_allowed(true);
+  assert(buffers_grew || (_cycles == 1) || (heap_allocation_count() == heap_allocations));
+#endif
+  return _new_traj;
+}
+
+// largest number of goals handed to evaluate_goals() at once
+int PolyTrajectoryGenerator::max_goals_per_batch() const {
+  // every goal family contributes its goal and its perturbations
+  int families = 4 * (1 + _goal_perturb_samples);
+  return max(families, max(_refine_samples, _warm_start_seeds));
+}
+
+// most a cycle puts on the arena: the goal list and warm start seeds, per rung a prioritized copy of the goals,
+// the refined goals and a candidate ordering, then the last keep lane goal and the warm start ordering.
+// A cycle cut short by the time budget may not get there, so the arena can't just grow to what was used.
+size_t PolyTrajectoryGenerator::arena_bytes() const {
+  int batch = max_goals_per_batch();
+  int candidates = _candidate_budget + _ladder_rungs + 1;
+  size_t goals = batch + _warm_start_seeds + _ladder_rungs * (batch + _refine_samples) + 1;
+  size_t orders = (_ladder_rungs + 1) * candidates;
+  // every allocation may lose some bytes to alignment
+  size_t allocations = 3 + 3 * _ladder_rungs;
+  return goals * sizeof(Goal) + orders * sizeof(int) + allocations * alignof(max_align_t);
+}
+
+// makes room for the worst case of the configured sampling. Returns whether anything had to be reallocated.
+bool PolyTrajectoryGenerator::reserve_buffers(int num_vehicles) {
+  bool grew = false;
+  int batch = max_goals_per_batch();
+  // the budget, the first goal of every rung and a last keep lane goal
+  int candidates = _candidate_budget + _ladder_rungs + 1;
+  grew = _candidates.reserve(candidates) || grew;
+  if (_goals_s.cols() < batch) {
+    _goals_s.resize(3, batch);
+    _goals_d.resize(3, batch);
+    _coeff_s.resize(6, batch);
+    _coeff_d.resize(6, batch);
+    grew = true;
+  }
+  grew = _samples.reserve(_horizon, batch) || grew;
+  grew = _arena.reserve(arena_bytes()) || grew;
+  if (_traffic_bounds.capacity() < size_t(num_vehicles)) {
+    _traffic_bounds.reserve(num_vehicles);
+    grew = true;
+  }
+  if (_collision_check_mode == CHECK_SAMPLED) {
+    grew = _traffic.reserve(_horizon, num_vehicles) || grew;
+    if (_traffic_scratch.size() < size_t(3 * batch * num_vehicles)) {
+      _traffic_scratch.resize(3 * batch * num_vehicles);
+      grew = true;
+    }
+  }
+  if (_warm_goals.capacity() < size_t(_warm_start_seeds)) {
+    _warm_goals.reserve(_warm_start_seeds);
+    grew = true;
+  }
+  if (_new_traj.size() != 2) {
+    _new_traj.resize(2);
+    _start_s.reserve(3);
+    _start_d.reserve(3);
+    grew = true;
+  }
+  for (vector<double> &values : _new_traj) {
+    if (values.capacity() < size_t(_horizon)) {
+      values.reserve(_horizon);
+      grew = true;
+    }
+  }
+  return grew;
 }
 
 
-// creates randomly generated variations of goal point
-void PolyTrajectoryGenerator::perturb_goal(vector<double> goal, vector<vector<double>> &goal_points, bool no_ahead) {
+// solves the jerk minimized trajectories to the given goal points and adds them, with their costs, to the candidates
+void PolyTrajectoryGenerator::evaluate_goals(vector<double> const &start_s, vector<double> const &start_d, GoalList const &goal_points, vector<Vehicle> const &vehicles, bool prefer_mid_lane, bool force) {
+  if (!force && out_of_time())
+    return;
+  int first = _candidates.size();
+  for (Goal const &goal : goal_points) {
+    // ignore goal points that are out of bounds
+    if ((goal[3] > 1.0) && (goal[3] < 11.0))
+      _candidates.goals.push_back(goal);
+  }
+  int num_traj = _candidates.size() - first;
+  if (num_traj == 0)
+    return;
+  PTG_COUNT(COUNT_CANDIDATES, num_traj);
+  // solve all goals at once
+  PTG_STAGE_BEGIN(jmt_timer, STAGE_JMT);
+  if (_goals_s.cols() < num_traj) {
+    _goals_s.resize(3, num_traj);
+    _goals_d.resize(3, num_traj);
+  }
+  for (int i = 0; i < num_traj; i++) {
+    Goal const &goal = _candidates.goals[first + i];
+    _goals_s.col(i) << goal[0], goal[1], goal[2];
+    _goals_d.col(i) << goal[3], goal[4], goal[5];
+  }
+  _jmt_solver.solve(start_s, _goals_s, num_traj, _coeff_s);
+  _jmt_solver.solve(start_d, _goals_d, num_traj, _coeff_d);
+  for (int i = 0; i < num_traj; i++) {
+    QuinticPolynomial traj_s_poly(_coeff_s.col(i).data());
+    QuinticPolynomial traj_d_poly(_coeff_d.col(i).data());
+    _candidates.trajectories.push_back(std::make_pair(traj_s_poly, traj_d_poly));
+  }
+  PTG_STAGE_END(jmt_timer);
+  // sample all of them over the horizon at once
+  PTG_TIMED(STAGE_SAMPLING, _time_basis.sample(_coeff_s, _coeff_d, num_traj, _samples));
+
+  // candidates are independent. Each one only writes its own slot, so the choice of trajectory
+  // doesn't depend on whether or how they are spread over threads.
+  _candidates.costs.resize(first + num_traj);
+  _candidates.cost_terms.resize(first + num_traj);
+  auto evaluate_candidate = [&](int i) {
+    int traj_i = first + i;
+    pair<QuinticPolynomial, QuinticPolynomial> const &traj = _candidates.trajectories[traj_i];
+    // anytime mode: candidates past the deadline count as infeasible
+    if (out_of_time()) {
+      _candidates.cost_terms[traj_i].fill(0.0);
+      _candidates.costs[traj_i] = 999999;
+      return;
+    }
+    double cost = calculate_cost(traj, _samples, i, _candidates.goals[traj_i], vehicles, _candidates.cost_terms[traj_i]);
+    // if appropriate, scale costs for trajectories going to the middle lane
+    if (prefer_mid_lane && (cost != 999999)) {
+      // if we are currently not in middle lane AND trajectory takes us into middle lane
+      if ((abs(6 - traj.second.eval(0)) > 1.0) && (abs(6 - traj.second.eval(_horizon)) < 1.0)) {
+        cost *= 0.6;
+      }
+    }
+    _candidates.costs[traj_i] = cost;
+  };
+  PTG_TIME_STAGE(STAGE_EVALUATION);
+  if (_thread_pool) {
+    _thread_pool->parallel_for(num_traj, evaluate_candidate);
+  } else {
+    for (int i = 0; i < num_traj; i++)
+      evaluate_candidate(i);
+  }
+}
+
+// creates variations of goal point
+void PolyTrajectoryGenerator::perturb_goal(Goal const &goal, GoalList &goal_points, bool no_ahead) {
   double percentage_std_deviation = 0.1;
-  std::normal_distribution<double> distribution_10_percent(0.0, percentage_std_deviation);
-  vector<double> pert_goal(6);
-  for (int i = 0; i < _goal_perturb_samples; i++) {
-    double multiplier = distribution_10_percent(_rand_generator);
+  Goal pert_goal;
+  for (int i = 0; i < _cycle_perturb_samples; i++) {
+    double multiplier, multiplier_d;
+    _sampler.normal_pair(percentage_std_deviation, multiplier, multiplier_d);
     if (no_ahead && (multiplier > 0.0))
       multiplier *= -1.0;
     pert_goal.at(0) = goal[0] + (_delta_s_maxspeed * multiplier);
     pert_goal.at(1) = goal[1] + (_max_dist_per_timestep * multiplier);
     pert_goal.at(2) = 0.0;
     
-    multiplier = distribution_10_percent(_rand_generator);
-    pert_goal.at(3) = goal[3] + multiplier;
+    pert_goal.at(3) = goal[3] + multiplier_d;
     pert_goal.at(4) = 0.0;
     pert_goal.at(5) = 0.0;
     goal_points.push_back(pert_goal);
   }
 }
 
+// last cycle's best goals, moved along in time by the timesteps driven since.
+// Goals keep their velocity while the new start sits on last cycle's best trajectory.
+void PolyTrajectoryGenerator::warm_start_goals(vector<double> const &start_s, GoalList &goal_points) {
+  if ((_warm_start_seeds == 0) || (_warm_horizon != _horizon))
+    return;
+  double start_advance = _warm_traj_s.eval(_warm_elapsed) - _warm_traj_s.eval(0);
+  for (Goal const &warm_goal : _warm_goals) {
+    Goal goal = warm_goal;
+    goal[0] = start_s[0] + warm_goal[0] + warm_goal[1] * _warm_elapsed - start_advance;
+    goal_points.push_back(goal);
+  }
+}
 
-Polynomial PolyTrajectoryGenerator::jmt(vector<double> const &start, vector<double> const &goal, int t) {
-  double T = double(t);
-  double t_2 = pow(T, 2);
-  double t_3 = pow(T, 3);
-  double t_4 = pow(T, 4);
-  double t_5 = pow(T, 5);
-  Eigen::Matrix3d A;
-  A << t_3,   t_4,    t_5,
-       3*t_2, 4*t_3,  5*t_4,
-       6*t,   12*t_2, 20*t_3;
+// keeps the best feasible candidates of this cycle as seeds for the next one
+void PolyTrajectoryGenerator::store_warm_start(vector<double> const &start_s, int situation) {
+  _warm_goals.clear();
+  _warm_situation = situation;
+  _warm_horizon = _horizon;
+  _warm_elapsed = 0;
+  ArenaVector<int> order(_arena);
+  feasible_by_cost(order);
+  for (int i = 0; (i < (int)order.size()) && (i < _warm_start_seeds); i++) {
+    Goal goal = _candidates.goals[order[i]];
+    goal[0] -= start_s[0];
+    _warm_goals.push_back(goal);
+  }
+  if (!order.empty())
+    _warm_traj_s = _candidates.trajectories[order[0]].first;
+}
+
+// drops the goals that don't fit in what is left of the cycle's candidate budget, but keeps at least min_goals
+void PolyTrajectoryGenerator::limit_to_budget(GoalList &goal_points, int min_goals) const {
+  int allowed = max(_candidate_budget - _candidates.size(), min_goals);
+  if ((int)goal_points.size() > allowed)
+    goal_points.resize(allowed);
+}
+
+// anytime order: the first goal of every family in priority order, then their first perturbations, and so on
+void PolyTrajectoryGenerator::prioritize_goals(GoalList &goal_points, int const *family_begin, int const *family_end, int const *family_order) {
+  GoalList generated(goal_points.begin(), goal_points.end(), ArenaAllocator<Goal>(_arena));
+  goal_points.clear();
+  for (int k = 0; goal_points.size() < generated.size(); k++) {
+    for (int f = 0; f < FAMILY_COUNT; f++) {
+      int i = family_begin[family_order[f]] + k;
+      if (i < family_end[family_order[f]])
+        goal_points.push_back(generated[i]);
+    }
+  }
+}
+
+// s distance to the closest vehicle ahead in a lane, 999 if there is none
+double PolyTrajectoryGenerator::room_ahead(double start_s, int lane, array<int, 3> const &closest_veh_i, vector<Vehicle> const &vehicles) const {
+  if (closest_veh_i[lane] == -1)
+    return 999;
+  return vehicles[closest_veh_i[lane]].s_at(0) - start_s;
+}
+
+bool PolyTrajectoryGenerator::out_of_time() const {
+  return (_time_budget_ms > 0.0) && (chrono::steady_clock::now() >= _deadline);
+}
+
+// indices of the feasible candidates, cheapest first. Ties keep candidate order.
+void PolyTrajectoryGenerator::feasible_by_cost(ArenaVector<int> &order) const {
+  order.reserve(_candidates.size());
+  for (int i = 0; i < _candidates.size(); i++) {
+    if (_candidates.costs[i] != 999999)
+      order.push_back(i);
+  }
+  // std::stable_sort would take a temporary buffer from the heap
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return (_candidates.costs[a] < _candidates.costs[b]) || ((_candidates.costs[a] == _candidates.costs[b]) && (a < b));
+  });
+}
+
+void PolyTrajectoryGenerator::shift_warm_start(int elapsed_timesteps) {
+  _warm_elapsed = elapsed_timesteps;
+}
+
+// one cross-entropy step: fits a normal distribution to the goals of the best feasible candidates so far
+// and samples new goal points from it
+void PolyTrajectoryGenerator::refine_goals(GoalList &goal_points) {
+  ArenaVector<int> order(_arena);
+  feasible_by_cost(order);
+  if (order.empty())
+    return;
+  int num_elites = min(_refine_elites, (int)order.size());
   
-  double b_0 = start[0] + start[1] * t + 0.5 * start[2] * t_2;
-  double b_1 = start[1] + start[2] * t;
-  double b_2 = start[2];
-  Eigen::MatrixXd b(3,1);
-  b << goal[0] - b_0, goal[1] - b_1, goal[2] - b_2;
+  // s position and velocity were perturbed together, d on its own
+  double mean[3] = {0.0, 0.0, 0.0};
+  double std_dev[3] = {0.0, 0.0, 0.0};
+  const int dims[3] = {0, 1, 3};
+  for (int k = 0; k < 3; k++) {
+    for (int e = 0; e < num_elites; e++)
+      mean[k] += _candidates.goals[order[e]][dims[k]] / num_elites;
+    for (int e = 0; e < num_elites; e++)
+      std_dev[k] += pow(_candidates.goals[order[e]][dims[k]] - mean[k], 2) / num_elites;
+    std_dev[k] = sqrt(std_dev[k]);
+  }
+  // don't let the distribution collapse onto a single goal
+  std_dev[0] = max(std_dev[0], 0.01 * _delta_s_maxspeed);
+  std_dev[1] = max(std_dev[1], 0.01 * _max_dist_per_timestep);
+  std_dev[2] = max(std_dev[2], 0.05);
   
-  Eigen::MatrixXd c = A.inverse() * b;
-  //Eigen::Vector3d c = A.colPivHouseholderQr().solve(b);
-  vector<double> coeff = {start[0], start[1], 0.5*start[2], c.data()[0], c.data()[1], c.data()[2]};
-  Polynomial result(coeff);
-  return result;
+  Goal refined_goal = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+  for (int i = 0; i < _refine_samples; i++) {
+    double multiplier, multiplier_d;
+    _sampler.normal_pair(1.0, multiplier, multiplier_d);
+    refined_goal[0] = mean[0] + std_dev[0] * multiplier;
+    refined_goal[1] = mean[1] + std_dev[1] * multiplier;
+    refined_goal[3] = mean[2] + std_dev[2] * multiplier_d;
+    goal_points.push_back(refined_goal);
+  }
 }
 
@@ -11,7 +11,10 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <array>
 #include <string>
+#include <chrono>
 #include <math.h>
 #include "Eigen-3.3/Eigen/Core"
 #include "Eigen-3.3/Eigen/QR"
@@ -19,59 +22,291 @@
 #include <random>
 #include "Polynomial.h"
 #include "Vehicle.h"
+#include "TimeBasis.h"
+#include "JmtSolver.h"
+#include "TimeIntervals.h"
+#include "ThreadPool.h"
+#include "GoalSampler.h"
+#include "CostPolicy.h"
+#include "Arena.h"
+#include "TrafficSnapshot.h"
+#include "TrafficPrediction.h"
 
 using namespace std;
 
+// accumulators filled by a single pass over a trajectory's time horizon
+struct TrajectoryEval {
+    double traffic_buffer = 0.0;
+    double accel_s = 0.0;
+    double accel_d = 0.0;
+    double jerk = 0.0;
+    double lane_depart = 0.0;
+};
+
+class PolyTrajectoryGenerator;
+
+// goal state of a trajectory: s, s_dot, s_double_dot, d, d_dot, d_double_dot
+typedef std::array<double, 6> Goal;
+// goal points of one planning cycle, on the cycle's arena
+typedef ArenaVector<Goal> GoalList;
+
+// everything the cost terms of one feasible candidate get to look at
+struct CostContext {
+    PolyTrajectoryGenerator *generator;
+    pair<QuinticPolynomial, QuinticPolynomial> const &traj;
+    Goal const &goal;
+    vector<Vehicle> const &vehicles;
+    TrajectoryEval const &eval;
+};
+
+// cost terms, see CostPolicy.h
+struct TrafficBufferTerm {
+    static char const *name() { return "traffic buffer"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.eval.traffic_buffer; }
+};
+
+struct EfficiencyTerm {
+    static char const *name() { return "efficiency"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.generator->efficiency_cost(c.traj, c.goal, c.vehicles); }
+};
+
+struct AccelSTerm {
+    static char const *name() { return "acceleration s"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.generator->logistic(c.eval.accel_s); }
+};
+
+struct AccelDTerm {
+    static char const *name() { return "acceleration d"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.generator->logistic(c.eval.accel_d); }
+};
+
+struct JerkTerm {
+    static char const *name() { return "jerk"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.generator->logistic(c.eval.jerk); }
+};
+
+struct LaneDepartTerm {
+    static char const *name() { return "lane depart"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.eval.lane_depart; }
+};
+
+struct TrafficAheadTerm {
+    static char const *name() { return "traffic"; }
+    template <class Context>
+    static double evaluate(Context const &c) { return c.generator->traffic_ahead_cost(c.traj, c.goal, c.vehicles); }
+};
+
+// the cost the planner minimizes. Build with PTG_TUNABLE_COST_WEIGHTS to set weights at runtime.
+#ifdef PTG_TUNABLE_COST_WEIGHTS
+typedef RuntimeCostPolicy<TrafficBufferTerm, EfficiencyTerm, AccelSTerm, AccelDTerm, JerkTerm, LaneDepartTerm, TrafficAheadTerm> PlannerCostPolicy;
+#define PTG_DEFAULT_COST_WEIGHTS 170.0, 110.0, 10.0, 10.0, 10.0, 0.01, 13.0
+#else
+typedef CostPolicy<WeightedTerm<TrafficBufferTerm, std::ratio<170>>,
+                   WeightedTerm<EfficiencyTerm, std::ratio<110>>,
+                   WeightedTerm<AccelSTerm, std::ratio<10>>,
+                   WeightedTerm<AccelDTerm, std::ratio<10>>,
+                   WeightedTerm<JerkTerm, std::ratio<10>>,
+                   WeightedTerm<LaneDepartTerm, std::ratio<1, 100>>,
+                   WeightedTerm<TrafficAheadTerm, std::ratio<13>>> PlannerCostPolicy;
+#endif
+typedef PlannerCostPolicy::TermValues CostTerms;
+
+// goal families, in the order they are generated
+enum GoalFamily {
+    FAMILY_STRAIGHT,
+    FAMILY_FOLLOW,
+    FAMILY_LEFT,
+    FAMILY_RIGHT,
+    FAMILY_COUNT
+};
+
+// how feasibility limits are decided
+enum CheckMode {
+    CHECK_ANALYTIC, // from the polynomial coefficients, before any per-timestep work
+    CHECK_SAMPLED   // at every timestep of the horizon
+};
+
+// s/d extent covered over the time horizon
+struct SweptBox {
+    double s_min;
+    double s_max;
+    double d_min;
+    double d_max;
+    
+    bool overlaps(SweptBox const &other) const {
+        return (s_min <= other.s_max) && (other.s_min <= s_max) && (d_min <= other.d_max) && (other.d_min <= d_max);
+    }
+};
+
+// all candidates evaluated in the current planning cycle
+struct CandidateSet {
+    vector<Goal> goals;
+    vector<pair<QuinticPolynomial, QuinticPolynomial>> trajectories;
+    vector<double> costs;
+    vector<CostTerms> cost_terms;
+    
+    int size() const {
+        return goals.size();
+    }
+    
+    void clear() {
+        goals.clear();
+        trajectories.clear();
+        costs.clear();
+        cost_terms.clear();
+    }
+    
+    // returns whether that took a reallocation
+    bool reserve(int count) {
+        if (goals.capacity() >= size_t(count))
+            return false;
+        goals.reserve(count);
+        trajectories.reserve(count);
+        costs.reserve(count);
+        cost_terms.reserve(count);
+        return true;
+    }
+};
+
 class PolyTrajectoryGenerator {
 public:
-    PolyTrajectoryGenerator();
+    PolyTrajectoryGenerator(unsigned int seed = 0);
     ~PolyTrajectoryGenerator();
     
-    vector<vector<double>> generate_trajectory(vector<double> const &start, double max_speed, double horizon, vector<Vehicle> const &vehicles);
-    Polynomial jmt(vector<double> const &start, vector<double> const &goal, int t);
-    void perturb_goal(vector<double> goal, vector<vector<double>> &goal_points, bool no_ahead=false);
+    // the returned s and d values stay valid until the next call. Both are empty if the time budget ran out
+    // before anything feasible was found, the previous trajectory is the best there is then.
+    vector<vector<double>> const &generate_trajectory(vector<double> const &start, double max_speed, double horizon, vector<Vehicle> const &vehicles);
+    void perturb_goal(Goal const &goal, GoalList &goal_points, bool no_ahead=false);
+    void refine_goals(GoalList &goal_points);
+    void warm_start_goals(vector<double> const &start_s, GoalList &goal_points);
+    void store_warm_start(vector<double> const &start_s, int situation);
+    // timesteps of the previous trajectory the vehicle has driven since it was planned
+    void shift_warm_start(int elapsed_timesteps);
+    // adds the goals to the candidates and costs them. Does nothing once the time budget has run out, unless forced.
+    void evaluate_goals(vector<double> const &start_s, vector<double> const &start_d, GoalList const &goal_points, vector<Vehicle> const &vehicles, bool prefer_mid_lane, bool force=false);
     double logistic(double x);
-    int closest_vehicle_in_lane(vector<double> const &start, int ego_lane_i, vector<Vehicle> const &vehicles);
-    vector<int> closest_vehicle_in_lanes(vector<double> const &start, vector<Vehicle> const &vehicles);
-    double calculate_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles, vector<vector<double>> &all_costs);
-    double exceeds_speed_limit_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double exceeds_accel_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double exceeds_jerk_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double collision_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double traffic_buffer_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double efficiency_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double total_accel_d_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double total_accel_s_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double total_jerk_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double lane_depart_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
-    double traffic_ahead_cost(pair<Polynomial, Polynomial> const &traj, vector<double> const &goal, vector<Vehicle> const &vehicles);
+    int closest_vehicle_in_lane(double start_s, int ego_lane_i, vector<Vehicle> const &vehicles);
+    array<int, 3> closest_vehicle_in_lanes(double start_s, vector<Vehicle> const &vehicles);
+    double calculate_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, TrajectorySamples const &samples, int traj_i, Goal const &goal, vector<Vehicle> const &vehicles, CostTerms &cost_terms);
+    bool within_dynamic_limits(pair<QuinticPolynomial, QuinticPolynomial> const &traj);
+    bool evaluate_traffic(pair<QuinticPolynomial, QuinticPolynomial> const &traj, vector<Vehicle> const &vehicles, TrajectoryEval &eval);
+    bool evaluate_trajectory(TrajectorySamples const &samples, int traj_i, vector<Vehicle> const &vehicles, TrajectoryEval &eval);
+    // cost terms that aren't accumulated per timestep by evaluate_trajectory()
+    double efficiency_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, Goal const &goal, vector<Vehicle> const &vehicles);
+    double traffic_ahead_cost(pair<QuinticPolynomial, QuinticPolynomial> const &traj, Goal const &goal, vector<Vehicle> const &vehicles);
     string get_current_action();
+    void set_limit_check_mode(CheckMode mode);
+    void set_collision_check_mode(CheckMode mode);
+    // evaluate candidates on a pool of num_threads threads (including the caller). 1 or less evaluates serially.
+    void set_num_threads(int num_threads);
+    // goal sampling. Everything random in the planner derives from the seed.
+    void set_seed(unsigned int seed);
+    void set_sampling_mode(SamplingMode mode);
+    void set_goal_samples(int samples);
+    // cross-entropy refinement: samples goals around the elites best candidates. 0 samples turns it off.
+    void set_refinement(int samples, int elites);
+    // warm start: re-cost the best seeds goals of the last cycle first. While the situation doesn't change
+    // and they stay feasible, only steady_samples fresh goals are generated per goal family. 0 seeds turns it off.
+    void set_warm_start(int seeds, int steady_samples);
+    // most candidates evaluated per cycle, over all rungs of the fallback ladder
+    void set_candidate_budget(int max_candidates);
+    // anytime mode: candidates are evaluated in priority order (keep lane, then the lane change with more room
+    // ahead) until milliseconds have passed since the start of the cycle, and the best one found by then
+    // is driven. 0 turns it off.
+    void set_time_budget(double milliseconds);
+    // planner counters and timers, see Instrumentation.h
+    PlannerStats get_stats() const;
+    void reset_stats();
+#ifdef PTG_TUNABLE_COST_WEIGHTS
+    // weight of the cost term called name. Returns false if there is no such term.
+    bool set_cost_weight(std::string const &name, double weight);
+#endif
     
 private:
+    template <int Degree>
+    bool exceeds_on_horizon(Polynomial<Degree> const &p, double limit) const;
+    bool reserve_buffers(int num_vehicles);
+    void feasible_by_cost(ArenaVector<int> &order) const;
+    void limit_to_budget(GoalList &goal_points, int min_goals) const;
+    void prioritize_goals(GoalList &goal_points, int const *family_begin, int const *family_end, int const *family_order);
+    double room_ahead(double start_s, int lane, array<int, 3> const &closest_veh_i, vector<Vehicle> const &vehicles) const;
+    bool out_of_time() const;
+    int max_goals_per_batch() const;
+    size_t arena_bytes() const;
+    void update_traffic_bounds();
+    void fallen_behind(TrajectorySamples const &samples, int traj_i, int vehicle, int &col_t, int &buf_t) const;
+    SweptBox swept_box(pair<QuinticPolynomial, QuinticPolynomial> const &traj) const;
+    double integrate_buffer_cost(QuinticPolynomial const &gap_s, TimeIntervals const &intervals, double sign);
+
     std::string _current_action = "straight";
+    CheckMode _limit_check_mode = CHECK_ANALYTIC;
+    CheckMode _collision_check_mode = CHECK_ANALYTIC;
     const double _car_width = 2.0;
     const double _car_length = 5.0;
     const double _car_col_width = 0.5 * _car_width;
     const double _car_col_length = 0.5 * _car_length;
     const double _col_buf_width = _car_width;
     const double _col_buf_length = 4 * _car_length;
-    const int _goal_perturb_samples = 15;
+    // how far ahead a vehicle still counts as the closest one in its lane
+    const float _look_ahead_range = 999;
+    int _goal_perturb_samples = 8;
+    int _refine_samples = 6;
+    int _refine_elites = 4;
+    int _warm_start_seeds = 3;
+    int _warm_start_samples = 3;
+    int _candidate_budget = 80;
+    double _time_budget_ms = 0.0;
+    chrono::steady_clock::time_point _deadline;
+    static const int _ladder_rungs = 4;
+    // perturbation samples per goal family in the current cycle
+    int _cycle_perturb_samples = 0;
     int _horizon = 0;
     const double _hard_max_vel_per_timestep = 0.00894 * 49.5; // 50 mp/h and a little buffer
     const double _hard_max_acc_per_timestep = 10.0 / 50.0; // 10 m/s
     const double _hard_max_jerk_per_timestep = 10.0 / 50.0; // 10 m/s
     double _max_dist_per_timestep = 0.0;
     double _delta_s_maxspeed = 0.0;
-    std::default_random_engine _rand_generator;
-    std::map<std::string, double> _cost_weights = {
-                                            {"tr_buf_cost", 170.0},
-                                            {"eff_cost", 110.0},
-                                            {"acc_s_cost", 10.0},
-                                            {"acc_d_cost", 10.0},
-                                            {"jerk_cost", 10.0},
-                                            {"lane_dep_cost", 0.01},
-                                            {"traffic_cost", 13.0},
-                                            };
+    GoalSampler _sampler;
+    // per-cycle temporaries. Reset at the start of every cycle.
+    Arena _arena;
+    vector<double> _start_s;
+    vector<double> _start_d;
+    vector<vector<double>> _new_traj;
+    CandidateSet _candidates;
+    // best goals of the last cycle, s position relative to its start
+    vector<Goal> _warm_goals;
+    QuinticPolynomial _warm_traj_s;
+    int _warm_horizon = 0;
+    int _warm_situation = -1;
+    int _warm_elapsed = 0;
+    TimeBasis _time_basis;
+    JmtSolver _jmt_solver;
+    GoalMatrix _goals_s;
+    GoalMatrix _goals_d;
+    CoefficientMatrix _coeff_s;
+    CoefficientMatrix _coeff_d;
+    TrajectorySamples _samples;
+    // vehicles of the current cycle that can matter to it. Planner loops index these, not the vehicles passed in.
+    TrafficSnapshot _snapshot;
+    // swept boxes of all vehicles of the current cycle, grown by the largest envelope
+    vector<SweptBox> _traffic_bounds;
+    // predicted traffic of the current cycle
+    TrafficPrediction _traffic;
+    // evaluate_trajectory() scratch per candidate of a batch: fallen behind times and nearby vehicles
+    vector<int> _traffic_scratch;
+    unique_ptr<ThreadPool> _thread_pool;
+    int _cycles = 0;
+#ifdef PTG_TUNABLE_COST_WEIGHTS
+    PlannerCostPolicy _cost_policy{PTG_DEFAULT_COST_WEIGHTS};
+#else
+    PlannerCostPolicy _cost_policy;
+#endif
 };
 
 #endif /* POLYTRAJECTORYGENERATOR_H */
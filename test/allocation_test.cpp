@@ -0,0 +1,54 @@
+/*
+ * File:   allocation_test.cpp
+ * Author: merbar
+ *
+ * Created on August 16, 2017, 10:30 PM
+ */
+
+#include "../src/polyTrajectoryGenerator.h"
+#include "../src/AllocationCounter.h"
+#include <cstdio>
+#include <random>
+
+// Runs the planner over synthetic traffic and fails if any planning cycle after the first one
+// touches the heap. Built with PTG_COUNT_ALLOCATIONS, so it checks even where asserts are compiled out.
+
+static const int num_cycles = 40;
+static const int num_vehicles = 12;
+
+// 0 if cycles after the first one are allocation free, the number of the first cycle that allocated otherwise
+static int first_allocating_cycle(int num_threads) {
+  PolyTrajectoryGenerator PTG;
+  PTG.set_num_threads(num_threads);
+  mt19937 rng(7);
+  uniform_real_distribution<double> random_s(-60.0, 240.0);
+  uniform_int_distribution<int> random_lane(0, 2);
+  uniform_real_distribution<double> random_vel(0.3, 0.45);
+  // the same number of vehicles every cycle, moved around in place
+  vector<Vehicle> vehicles(num_vehicles);
+  vector<double> start = {90, 0.40, 0.0, 6.0, 0.0, 0.0};
+  for (int cycle = 1; cycle <= num_cycles; cycle++) {
+    for (Vehicle &vehicle : vehicles) {
+      vehicle.set_frenet_pos(start[0] + random_s(rng), 2 + 4 * random_lane(rng));
+      vehicle.set_frenet_motion(random_vel(rng), 0, 0, 0);
+    }
+    uint64_t allocations = heap_allocation_count();
+    PTG.generate_trajectory(start, 48.5, 175, vehicles);
+    if ((cycle > 1) && (heap_allocation_count() != allocations))
+      return cycle;
+  }
+  return 0;
+}
+
+int main() {
+  int result = 0;
+  int const thread_counts[] = {1, 4};
+  for (int num_threads : thread_counts) {
+    int cycle = first_allocating_cycle(num_threads);
+    if (cycle != 0) {
+      fprintf(stderr, "planning cycle %d allocated on the heap with %d thread(s)\n", cycle, num_threads);
+      result = 1;
+    }
+  }
+  return result;
+}
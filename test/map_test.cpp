@@ -0,0 +1,94 @@
+/*
+ * File:   map_test.cpp
+ * Author: merbar
+ *
+ * Created on August 20, 2017, 6:30 PM
+ */
+
+#include "../src/Map.h"
+#include <chrono>
+#include <cstdio>
+#include <math.h>
+#include <random>
+
+// Checks the k-d tree nearest waypoint lookup of Map against a scan over all waypoints, around
+// the maps given on the command line and on a synthetic 100k waypoint loop. Prints the time per
+// query of both, so the speedup on a large map can be seen too.
+//
+// usage: map_test <map file>...
+
+// closest waypoint by a scan over all of them. Ties go to the lowest index.
+static int scan(Map const &map, double x, double y) {
+  double closest_dist = 1e300;
+  int closest = 0;
+  for (int i = 0; i < map.size(); i++) {
+    double dist = sqrt(pow(x - map.x()[i], 2) + pow(y - map.y()[i], 2));
+    if (dist < closest_dist) {
+      closest_dist = dist;
+      closest = i;
+    }
+  }
+  return closest;
+}
+
+// number of queries near random waypoints for which the tree and the scan disagree
+static int mismatches(char const *name, Map const &map, int num_queries) {
+  mt19937 rng(3);
+  uniform_int_distribution<int> random_waypoint(0, map.size() - 1);
+  normal_distribution<double> random_offset(0, 30);
+  int mismatches = 0;
+  double scan_us = 0;
+  double tree_us = 0;
+  for (int k = 0; k < num_queries; k++) {
+    int w = random_waypoint(rng);
+    double x = map.x()[w];
+    double y = map.y()[w];
+    // every fourth query exactly on a waypoint
+    if (k % 4 != 0) {
+      x += random_offset(rng);
+      y += random_offset(rng);
+    }
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+    int expected = scan(map, x, y);
+    chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+    int closest = map.closest_waypoint(x, y);
+    chrono::steady_clock::time_point t2 = chrono::steady_clock::now();
+    scan_us += chrono::duration<double, micro>(t1 - t0).count();
+    tree_us += chrono::duration<double, micro>(t2 - t1).count();
+    if (closest != expected) {
+      fprintf(stderr, "%s: closest waypoint to %.3f, %.3f is %d, not %d\n", name, x, y, closest, expected);
+      mismatches++;
+    }
+    int next = map.next_waypoint(x, y, 0.0);
+    if ((next < 0) || (next >= map.size())) {
+      fprintf(stderr, "%s: next waypoint %d of %.3f, %.3f is out of range\n", name, next, x, y);
+      mismatches++;
+    }
+  }
+  printf("%s: %d waypoints, %d queries, scan %.3f us, tree %.3f us per query\n", name, map.size(), num_queries,
+         scan_us / num_queries, tree_us / num_queries);
+  return mismatches;
+}
+
+int main(int argc, char **argv) {
+  int failures = 0;
+  for (int i = 1; i < argc; i++) {
+    Map map;
+    if (!map.load(argv[i])) {
+      fprintf(stderr, "%s: no waypoints\n", argv[i]);
+      failures++;
+      continue;
+    }
+    failures += mismatches(argv[i], map, 20000);
+  }
+  // a wavy loop far larger than any track
+  Map loop;
+  int n = 100000;
+  for (int i = 0; i < n; i++) {
+    double a = 2 * M_PI * i / n;
+    loop.add_waypoint(50000 * cos(a) + 3000 * sin(7 * a), 30000 * sin(a), i, 0, 0);
+  }
+  loop.build_index();
+  failures += mismatches("synthetic loop", loop, 200);
+  return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+/*
+ * File:   planner_benchmark.cpp
+ * Author: merbar
+ *
+ * Created on August 12, 2017, 2:10 PM
+ */
+
+#include "../src/polyTrajectoryGenerator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+// Replays 200 planning cycles of a synthetic scene and prints the planning time and a checksum
+// of the chosen trajectories to stderr, stdout has the planner's own output. The same scene and options always give the same checksum, so a
+// change that shouldn't alter the plans can be checked by comparing it before and after.
+// Build with -DPTG_INSTRUMENTATION=ON to also get candidate, rejection and fallback counts.
+//
+// usage: planner_benchmark [random|stress|cruise] [options]
+//   random  12 vehicles around the ego vehicle, placed anew every cycle (default)
+//   stress  1000 vehicles spread over the whole track, placed anew every cycle
+//   cruise  three lanes of traffic moving along, the ego vehicle replans from its last plan
+// options:
+//   -v <n>   number of vehicles in the random and stress scenes
+//   -t <n>   planner threads
+//   -s       sampled instead of analytic limit and collision checks
+//   -b <ms>  time budget per cycle, 0 is unlimited
+//   -w <n>   warm start seeds, 0 turns warm starting off
+
+static const int num_cycles = 200;
+static const int horizon = 175;
+// timesteps driven between two cycles of the cruise scene
+static const int replan_interval = 50;
+
+struct Result {
+    double total_ms = 0;
+    double worst_ms = 0;
+    int empty = 0;
+    double checksum = 0;
+};
+
+static vector<vector<double>> const &plan(PolyTrajectoryGenerator &PTG, vector<double> const &start, vector<Vehicle> const &vehicles,
+                                          Result &result) {
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+  vector<vector<double>> const &path = PTG.generate_trajectory(start, 48.5, horizon, vehicles);
+  double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+  result.total_ms += ms;
+  result.worst_ms = max(result.worst_ms, ms);
+  if (path[0].empty())
+    result.empty++;
+  else
+    result.checksum += path[0][horizon - 1] + path[1][horizon - 1];
+  return path;
+}
+
+// vehicles at random s in [s_min, s_max), plus one far ahead in every lane
+static void random_scene(PolyTrajectoryGenerator &PTG, int num_vehicles, double s_min, double s_max, Result &result) {
+  mt19937 rng(7);
+  uniform_real_distribution<double> random_s(s_min, s_max);
+  uniform_real_distribution<double> random_lane(0, 3);
+  uniform_real_distribution<double> random_vel(0.3, 0.45);
+  vector<double> start = {90, 0.40, 0.0, 6.0, 0.0, 0.0};
+  vector<Vehicle> vehicles(num_vehicles + 3);
+  for (int cycle = 0; cycle < num_cycles; cycle++) {
+    for (int i = 0; i < num_vehicles; i++) {
+      double s = random_s(rng);
+      int lane = int(random_lane(rng));
+      vehicles[i].set_frenet_pos(s, 2 + 4 * lane);
+      vehicles[i].set_frenet_motion(random_vel(rng), 0, 0, 0);
+    }
+    for (int lane = 0; lane < 3; lane++) {
+      vehicles[num_vehicles + lane].set_frenet_pos(900, 2 + 4 * lane);
+      vehicles[num_vehicles + lane].set_frenet_motion(0.4, 0, 0, 0);
+    }
+    plan(PTG, start, vehicles, result);
+  }
+}
+
+// a vehicle ahead and one behind in every lane, all at the same speed. The ego vehicle
+// starts every cycle where the previous plan has it after replan_interval timesteps.
+static void cruise_scene(PolyTrajectoryGenerator &PTG, Result &result) {
+  vector<double> start = {0, 0.40, 0.0, 6.0, 0.0, 0.0};
+  vector<Vehicle> vehicles(6);
+  double traffic_s = 0;
+  for (int cycle = 0; cycle < num_cycles; cycle++) {
+    for (int lane = 0; lane < 3; lane++) {
+      vehicles[lane].set_frenet_pos(traffic_s + 60 + 20 * lane, 2 + 4 * lane);
+      vehicles[lane].set_frenet_motion(0.38, 0, 0, 0);
+      vehicles[3 + lane].set_frenet_pos(traffic_s - 40, 2 + 4 * lane);
+      vehicles[3 + lane].set_frenet_motion(0.38, 0, 0, 0);
+    }
+    PTG.shift_warm_start(replan_interval);
+    vector<vector<double>> const &path = plan(PTG, start, vehicles, result);
+    if (path[0].empty())
+      break;
+    vector<double> const &s = path[0];
+    vector<double> const &d = path[1];
+    int t = replan_interval;
+    start = {s[t], s[t + 1] - s[t], s[t + 2] - 2 * s[t + 1] + s[t],
+             d[t], d[t + 1] - d[t], d[t + 2] - 2 * d[t + 1] + d[t]};
+    traffic_s += 0.38 * replan_interval;
+  }
+}
+
+int main(int argc, char **argv) {
+  char const *scene = "random";
+  int num_vehicles = -1;
+  PolyTrajectoryGenerator PTG;
+  for (int i = 1; i < argc; i++) {
+    bool has_value = (i + 1 < argc);
+    if (!strcmp(argv[i], "-v") && has_value)
+      num_vehicles = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "-t") && has_value)
+      PTG.set_num_threads(atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-s")) {
+      PTG.set_limit_check_mode(CHECK_SAMPLED);
+      PTG.set_collision_check_mode(CHECK_SAMPLED);
+    } else if (!strcmp(argv[i], "-b") && has_value)
+      PTG.set_time_budget(atof(argv[++i]));
+    else if (!strcmp(argv[i], "-w") && has_value)
+      PTG.set_warm_start(atoi(argv[++i]), 3);
+    else if (argv[i][0] != '-')
+      scene = argv[i];
+    else {
+      fprintf(stderr, "unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  Result result;
+  if (!strcmp(scene, "random"))
+    random_scene(PTG, (num_vehicles < 0) ? 12 : num_vehicles, -10, 290, result);
+  else if (!strcmp(scene, "stress"))
+    random_scene(PTG, (num_vehicles < 0) ? 1000 : num_vehicles, 0, 6900, result);
+  else if (!strcmp(scene, "cruise"))
+    cruise_scene(PTG, result);
+  else {
+    fprintf(stderr, "unknown scene %s\n", scene);
+    return 1;
+  }
+
+  PlannerStats stats = PTG.get_stats();
+  if (stats.enabled)
+    stats.print(cerr);
+  fprintf(stderr, "%s: %d cycles, avg %.3f ms, worst %.3f ms, %d without a trajectory, checksum %.6f\n",
+         scene, num_cycles, result.total_ms / num_cycles, result.worst_ms, result.empty, result.checksum);
+  return 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * File:   time_budget_test.cpp
+ * Author: merbar
+ *
+ * Created on August 20, 2017, 8:45 PM
+ */
+
+#include "../src/polyTrajectoryGenerator.h"
+#include <cstdio>
+#include <math.h>
+#include <random>
+
+// Plans with time budgets from a few microseconds up to about a full cycle, so the deadline
+// runs out at every stage of the fallback ladder. Every cycle has to come back with either
+// no trajectory or a complete one. Built with _GLIBCXX_ASSERTIONS, so reading a candidate
+// that was never added aborts instead of going unnoticed.
+
+static const int num_budgets = 60;
+static const int cycles_per_budget = 20;
+static const int num_vehicles = 12;
+static const int horizon = 175;
+
+// number of cycles that returned a partial or broken trajectory
+static int broken_cycles(int num_threads) {
+  PolyTrajectoryGenerator PTG;
+  PTG.set_num_threads(num_threads);
+  mt19937 rng(5);
+  uniform_real_distribution<double> random_s(-10.0, 290.0);
+  uniform_int_distribution<int> random_lane(0, 2);
+  uniform_real_distribution<double> random_vel(0.3, 0.45);
+  vector<Vehicle> vehicles(num_vehicles);
+  vector<double> start = {90, 0.40, 0.0, 6.0, 0.0, 0.0};
+  int broken = 0;
+  for (int b = 0; b < num_budgets; b++) {
+    // 2 us to about 0.5 ms, in even steps on a log scale
+    PTG.set_time_budget(0.002 * pow(1.1, b));
+    for (int cycle = 0; cycle < cycles_per_budget; cycle++) {
+      for (Vehicle &vehicle : vehicles) {
+        double s = random_s(rng);
+        int lane = random_lane(rng);
+        vehicle.set_frenet_pos(s, 2 + 4 * lane);
+        vehicle.set_frenet_motion(random_vel(rng), 0, 0, 0);
+      }
+      vector<vector<double>> const &path = PTG.generate_trajectory(start, 48.5, horizon, vehicles);
+      if (path[0].empty() && path[1].empty())
+        continue;
+      bool complete = ((int)path[0].size() == horizon) && ((int)path[1].size() == horizon);
+      for (int t = 0; complete && (t < horizon); t++)
+        complete = isfinite(path[0][t]) && isfinite(path[1][t]);
+      if (!complete)
+        broken++;
+    }
+  }
+  return broken;
+}
+
+int main() {
+  int result = 0;
+  int const thread_counts[] = {1, 4};
+  for (int num_threads : thread_counts) {
+    int broken = broken_cycles(num_threads);
+    if (broken > 0) {
+      fprintf(stderr, "%d planning cycles returned a broken trajectory with %d thread(s)\n", broken, num_threads);
+      result = 1;
+    }
+  }
+  return result;
+}
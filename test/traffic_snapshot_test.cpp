@@ -0,0 +1,75 @@
+/*
+ * File:   traffic_snapshot_test.cpp
+ * Author: merbar
+ *
+ * Created on August 19, 2017, 9:15 PM
+ */
+
+#include "../src/TrafficSnapshot.h"
+#include <cstdio>
+#include <random>
+
+// Checks the binary search leader and follower lookups of TrafficSnapshot against a scan over
+// all vehicles, for query positions across the whole range the planner asks about.
+
+static const double ego_s = 1000;
+static const double look_ahead = 999;
+static const double max_travel = 160;
+static const double reach = 25;
+static const int horizon = 175;
+
+// closest vehicle in lane ahead of / behind s over all vehicles, -1 if there is none
+static int scan(vector<Vehicle> const &vehicles, int lane, double s, bool ahead) {
+  int closest = -1;
+  for (int i = 0; i < (int)vehicles.size(); i++) {
+    double s_i = vehicles[i].s_at(0);
+    if ((lane_of(vehicles[i].d_at(0)) != lane) || (ahead ? (s_i <= s) || (s_i - ego_s >= look_ahead) : (s_i >= s)))
+      continue;
+    if ((closest == -1) || (ahead ? (s_i < vehicles[closest].s_at(0)) : (s_i > vehicles[closest].s_at(0))))
+      closest = i;
+  }
+  return closest;
+}
+
+int main() {
+  mt19937 rng(11);
+  uniform_real_distribution<double> random_s(0, 3000);
+  uniform_real_distribution<double> random_d(0, 12);
+  uniform_real_distribution<double> random_vel(0, 0.5);
+  uniform_real_distribution<double> random_query(ego_s - reach, ego_s + max_travel + reach);
+  int failures = 0;
+  for (int round = 0; round < 10; round++) {
+    vector<Vehicle> vehicles(2000);
+    for (Vehicle &vehicle : vehicles) {
+      double s = random_s(rng);
+      double d = random_d(rng);
+      vehicle.set_frenet_pos(s, d);
+      vehicle.set_frenet_motion(random_vel(rng), 0, 0, 0);
+    }
+    TrafficSnapshot snapshot;
+    snapshot.build(vehicles, ego_s, look_ahead, max_travel, reach, horizon);
+    for (int query = 0; query < 500; query++) {
+      double s = random_query(rng);
+      for (int lane = 0; lane < TrafficSnapshot::num_lanes; lane++) {
+        int leader = snapshot.leader(lane, s);
+        leader = (leader == -1) ? -1 : snapshot.source(leader);
+        int expected_leader = scan(vehicles, lane, s, true);
+        if (leader != expected_leader) {
+          fprintf(stderr, "leader of lane %d at s %.3f: %d instead of %d\n", lane, s, leader, expected_leader);
+          failures++;
+        }
+        // only vehicles in reach are kept, so a follower further behind may be missing
+        int expected_follower = scan(vehicles, lane, s, false);
+        if ((expected_follower == -1) || (vehicles[expected_follower].s_at(0) < ego_s - reach))
+          continue;
+        int follower = snapshot.follower(lane, s);
+        follower = (follower == -1) ? -1 : snapshot.source(follower);
+        if (follower != expected_follower) {
+          fprintf(stderr, "follower of lane %d at s %.3f: %d instead of %d\n", lane, s, follower, expected_follower);
+          failures++;
+        }
+      }
+    }
+  }
+  return (failures == 0) ? 0 : 1;
+}